@@ -110,6 +110,45 @@ void token::transfer( name    from,
     add_balance( to, quantity, payer );
 }
 
+void token::transfermany( name                               from,
+                          std::vector<std::pair<name, asset>> transfers,
+                          string                             memo )
+{
+    require_auth( from );
+    eosio_assert( !transfers.empty(), "no transfers given" );
+    eosio_assert( memo.size() <= 256, "memo has more than 256 bytes" );
+
+    // Every transfer must use the same symbol, so the stat row is read once for the batch
+    auto sym = transfers.front().second.symbol;
+    stats statstable( _self, sym.code().raw() );
+    const auto& st = statstable.get( sym.code().raw() );
+    eosio_assert( sym == st.supply.symbol, "symbol precision mismatch" );
+
+    require_recipient( from );
+
+    asset total( 0, sym );
+    for( const auto& t : transfers ) {
+       const name&  to       = t.first;
+       const asset& quantity = t.second;
+
+       eosio_assert( from != to, "cannot transfer to self" );
+       eosio_assert( is_account( to ), "to account does not exist");
+       eosio_assert( quantity.is_valid(), "invalid quantity" );
+       eosio_assert( quantity.amount > 0, "must transfer positive quantity" );
+       eosio_assert( quantity.symbol == sym, "all transfers must use the same symbol" );
+
+       require_recipient( to );
+       total += quantity;
+    }
+
+    // The sender is debited once for the whole batch
+    sub_balance( from, total );
+    for( const auto& t : transfers ) {
+       auto payer = has_auth( t.first ) ? t.first : from;
+       add_balance( t.first, t.second, payer );
+    }
+}
+
 void token::sub_balance( name owner, asset value ) {
    accounts from_acnts( _self, owner.value );
 
@@ -167,4 +206,4 @@ void token::close( name owner, const symbol& symbol )
 
 } /// namespace eosio
 
-EOSIO_DISPATCH( eosio::token, (create)(issue)(transfer)(open)(close)(retire) )
+EOSIO_DISPATCH( eosio::token, (create)(issue)(transfer)(transfermany)(open)(close)(retire) )
@@ -8,6 +8,8 @@
 #include <eosiolib/eosio.hpp>
 
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace eosiosystem {
    class system_contract;
@@ -37,6 +39,11 @@ namespace eosio {
                         asset   quantity,
                         string  memo );
 
+         [[eosio::action]]
+         void transfermany( name                               from,
+                            std::vector<std::pair<name, asset>> transfers,
+                            string                             memo );
+
          [[eosio::action]]
          void open( name owner, const symbol& symbol, name ram_payer );
 
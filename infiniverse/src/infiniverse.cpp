@@ -1,158 +1,428 @@
 #include "infiniverse.hpp"
 #include "lat_long_functions.cpp"
+#include "z_order_functions.cpp"
 
 const uint32_t seconds_in_one_year = 60 * 60 * 24 * 365;
 const uint32_t max_land_length = 100;
+const uint32_t max_renewal_years = 10;
+const int64_t max_land_length_mm = max_land_length * 1000;
+// A batch is checked with one walk over its bounding box, so the box must stay small for the walk to stay cheap
+const uint32_t max_batch_length = 10 * max_land_length;
 const symbol inf_symbol = symbol("INF", 4);
 const name inf_account = "infinicoinio"_n;
 const uint32_t inf_per_sqm = 10;
+const uint32_t charges_per_settlement = 100;
+// Rows a registration may erase to reclaim expired lands in its way, larger ones must go through reaplands
+const uint32_t max_reclaimed_rows = 50;
+// Kept back from every memo registration to buy the RAM of the land row and its index entries,
+// which the contract pays for as RAM cannot be billed to the sender from a notification
+const asset memo_land_ram_fee = asset(10000, inf_symbol);
+// Packed records per changes action, under the chain's default max_inline_action_size of 4 KB with room
+// for the action's own overhead
+const size_t max_changes_action_bytes = 3 * 1024;
+// Transfer memo that registers a land, edges in decimal degrees "register:north,east,south,west"
+const std::string register_memo_prefix = "register:";
 
 void infiniverse::registerland(name owner, double lat_north_edge,
     double long_east_edge, double lat_south_edge, double long_west_edge)
 {
     require_auth(owner);
+    assert_lands_migrated();
 
-    eosio_assert(lat_north_edge > lat_south_edge, "North edge must have greater latitude than south edge");
-    // Temporary restriction of registering land across the antimeridian to simplify land intersection algorithm
-    eosio_assert(long_east_edge > long_west_edge, "East edge must have greater longitude than west edge");
-    // Temporary longitude limit to between -85 and 85 degrees to simplify display of lands on a mapping UI
-    eosio_assert(lat_north_edge < 85, "Latitude cannot be greater than 85 degrees");
-    eosio_assert(lat_south_edge > -85, "Latitude cannot be less than -85 degrees");
-    eosio_assert(long_east_edge <= 180 && long_east_edge > -180 && long_west_edge <= 180
-        && long_west_edge > -180, "Longitude must be between -180 and 180 degrees");
+    land_bounds bounds = to_land_bounds(lat_north_edge, long_east_edge, lat_south_edge, long_west_edge);
+    asset inf_amount = get_registration_fee(bounds);
 
-    std::pair<double, double> land_size = lat_long_to_meters(lat_north_edge, lat_south_edge,
-        long_east_edge, long_west_edge);
+    assert_land_available(bounds);
 
-    eosio_assert(land_size.first <= max_land_length && land_size.second <= max_land_length,
-        ("Land cannot exceed a length of " + std::to_string(max_land_length) + " meters on either side").c_str());
+    charge_deposit(owner, inf_amount);
 
-    land_table lands(_self, _self.value);
+    add_land(owner, bounds, owner);
+}
 
-    auto lat_north_index = lands.get_index<"bylatnorth"_n>();
-    auto lands_itr = lat_north_index.lower_bound(lat_south_edge);
-    // Add max_land_length meters to lat_north_edge to get upper bound
-    double upper_bound = lat_north_edge + meters_to_lat_dist(max_land_length);
+void infiniverse::registerlands(name owner, std::vector<land_rect> rects)
+{
+    require_auth(owner);
+    assert_lands_migrated();
+    eosio_assert(!rects.empty(), "No lands to register");
 
-    while(lands_itr != lat_north_index.end() && lands_itr->lat_north_edge < upper_bound)
+    std::vector<land_bounds> batch;
+    batch.reserve(rects.size());
+    asset inf_amount = asset(0, inf_symbol);
+    for(const land_rect& rect : rects)
     {
-        eosio_assert(
-            lands_itr->long_east_edge <= long_west_edge ||
-            lands_itr->long_west_edge >= long_east_edge ||
-            lands_itr->lat_south_edge >= lat_north_edge ||
-            // Required because lower bound includes equality case
-            lands_itr->lat_north_edge <= lat_south_edge,
-            "Intersecting land has already been registered");
-        lands_itr++;
+        batch.push_back(to_land_bounds(rect.lat_north_edge, rect.long_east_edge,
+            rect.lat_south_edge, rect.long_west_edge));
+        inf_amount += get_registration_fee(batch.back());
     }
 
-    // Calculate registration fee assuming each side is at least 1 meter to avoid abuse
-    // Otherwise a malicious user could register a very thin, long and cheap land
-    // This land would be useless but would stop anyone else from registering land over it
-    double land_area = std::max(land_size.first, 1.0) * std::max(land_size.second, 1.0);
-    int64_t reg_fee = static_cast<int64_t>(round(land_area * inf_per_sqm));
-    // multiply fee by 10000 to account for four decimal places of INF
-    asset inf_amount = asset(reg_fee * 10000, inf_symbol);
+    // Also sorts the batch from west to east
+    assert_batch_disjoint(batch);
 
-    deposit_table deposits(_self, _self.value);
-    auto deposits_itr = deposits.find(owner.value);
-    eosio_assert(deposits_itr != deposits.end(), "User does not have a deposit opened");
-    eosio_assert(deposits_itr->balance >= inf_amount, "User's INF deposit balance is too low");
+    // Check the whole batch against existing lands with one walk over its bounding box
+    int32_t lat_north = batch.front().lat_north_edge;
+    int32_t lat_south = batch.front().lat_south_edge;
+    int32_t long_east = batch.front().long_east_edge;
+    int32_t long_west = batch.front().long_west_edge;
+    for(const land_bounds& bounds : batch)
+    {
+        lat_north = std::max(lat_north, bounds.lat_north_edge);
+        lat_south = std::min(lat_south, bounds.lat_south_edge);
+        long_east = std::max(long_east, bounds.long_east_edge);
+    }
+    eosio_assert(lat_north - lat_south <= millimeters_to_lat_span(max_batch_length * 1000)
+        && long_east - long_west <= millimeters_to_long_span(max_batch_length * 1000, lat_north, lat_south),
+        ("Lands in a batch must lie within " + std::to_string(max_batch_length) + " meters of each other").c_str());
 
-    deposits.modify(deposits_itr, same_payer, [&](auto &row){
-        row.balance -= inf_amount;
-    });
+    int32_t lat_south_bound = lat_south - millimeters_to_lat_span(max_land_length_mm);
+    int32_t long_west_bound = long_west - millimeters_to_long_span(max_land_length_mm, lat_north, lat_south);
 
-    // The registration fee gets sent back to the token issuing account
-    transfer_inf(_self, inf_account, inf_amount, "");
+    std::vector<uint64_t> expired_land_ids;
+    for_each_land_in_box(lat_north, long_east, lat_south_bound, long_west_bound,
+        [&](const land& existing_land) {
+            // Only batch lands starting west of the existing east edge can reach it
+            auto batch_end = std::lower_bound(batch.begin(), batch.end(), existing_land.long_east_edge,
+                [](const land_bounds& bounds, int32_t long_east_edge) {
+                    return bounds.long_west_edge < long_east_edge;
+                });
+            for(auto batch_itr = batch.begin(); batch_itr != batch_end; batch_itr++)
+            {
+                if(lands_intersect(existing_land, *batch_itr))
+                {
+                    assert_expired(existing_land);
+                    expired_land_ids.push_back(existing_land.id);
+                    break;
+                }
+            }
+        });
+    reclaim_lands(expired_land_ids);
 
-    lands.emplace(owner, [&](auto &row) {
-        row.id = lands.available_primary_key();
-        row.owner = owner;
-        row.lat_north_edge = lat_north_edge;
-        row.long_east_edge = long_east_edge;
-        row.lat_south_edge = lat_south_edge;
-        row.long_west_edge = long_west_edge;
-        row.reg_end_date = time_point_sec(now() + seconds_in_one_year);
-    });
+    charge_deposit(owner, inf_amount);
+
+    for(const land_bounds& bounds : batch)
+    {
+        add_land(owner, bounds, owner);
+    }
 }
 
-void infiniverse::persistpoly(uint64_t land_id, std::string poly_id,
-        vector3 position, vector3 orientation, vector3 scale)
+void infiniverse::renewlands(name owner, std::vector<uint64_t> land_ids, uint32_t years)
+{
+    require_auth(owner);
+    assert_lands_migrated();
+    eosio_assert(!land_ids.empty(), "No lands to renew");
+    eosio_assert(years > 0, "Lands must be renewed for at least one year");
+
+    std::sort(land_ids.begin(), land_ids.end());
+    eosio_assert(std::adjacent_find(land_ids.begin(), land_ids.end()) == land_ids.end(),
+        "Land Ids must be unique");
+
+    // One walk over the owner's lands finds every land to renew and proves its ownership
+    auto owner_index = lands.get_index<"byowner"_n>();
+    asset inf_amount = asset(0, inf_symbol);
+    size_t lands_renewed = 0;
+    for(auto lands_itr = owner_index.lower_bound(owner.value);
+        lands_itr != owner_index.end() && lands_itr->owner == owner; lands_itr++)
+    {
+        if(!std::binary_search(land_ids.begin(), land_ids.end(), lands_itr->id))
+        {
+            continue;
+        }
+
+        land_bounds bounds{lands_itr->lat_north_edge, lands_itr->long_east_edge,
+            lands_itr->lat_south_edge, lands_itr->long_west_edge};
+        inf_amount += get_registration_fee(bounds) * years;
+
+        // A lapsed land that has not been reaped yet is renewed from now
+        uint64_t renew_from = std::max(lands_itr->reg_end_date.utc_seconds, now());
+        uint64_t reg_end_date = renew_from + (uint64_t)years * seconds_in_one_year;
+        eosio_assert(reg_end_date <= now() + (uint64_t)max_renewal_years * seconds_in_one_year,
+            ("Lands cannot be registered more than " + std::to_string(max_renewal_years) + " years ahead").c_str());
+        owner_index.modify(lands_itr, same_payer, [&](auto &row) {
+            row.reg_end_date = time_point_sec(static_cast<uint32_t>(reg_end_date));
+        });
+        record_upsert("land"_n, _self.value, *lands_itr);
+        lands_renewed++;
+    }
+    eosio_assert(lands_renewed == land_ids.size(), "Land Id does not exist or is not owned by the user");
+
+    charge_deposit(owner, inf_amount);
+}
+
+// Bulk loads lands without the fee or the walk over existing lands, so a batch can span the whole map.
+// The batch is swept for overlaps between its own lands. Overlaps with lands already in the table are
+// not checked here, the contract account has to run tools/import_lands against a snapshot of the table
+// to check them and to split the set into batches.
+void infiniverse::importlands(std::vector<imported_land> imports)
+{
+    require_auth(_self);
+    assert_lands_migrated();
+    eosio_assert(!imports.empty(), "No lands to import");
+
+    std::vector<land_bounds> batch;
+    batch.reserve(imports.size());
+    for(const imported_land& import : imports)
+    {
+        eosio_assert(is_account(import.owner), "Land owner account does not exist");
+        batch.push_back(land_bounds{import.lat_north_edge, import.long_east_edge,
+            import.lat_south_edge, import.long_west_edge});
+        assert_valid_land_bounds(batch.back());
+        // Overlap queries only look one maximum land length around a land, so that limit must hold here too
+        assert_land_length(batch.back());
+    }
+    assert_batch_disjoint(batch);
+
+    // Lands get their ids in the order they were given
+    for(const imported_land& import : imports)
+    {
+        add_land(import.owner, land_bounds{import.lat_north_edge, import.long_east_edge,
+            import.lat_south_edge, import.long_west_edge}, _self);
+    }
+}
+
+// Rewrites at most max_rows lands stored with double edges in the micro degree layout, keeping their ids.
+// The contract pays for the rewritten rows since their owners are not signing, the owners get back
+// the RAM of their legacy rows. Land actions are refused until every land has been rewritten.
+void infiniverse::migratelands(uint32_t max_rows)
+{
+    require_auth(_self);
+    eosio_assert(max_rows > 0, "Must allow at least one land to be migrated");
+
+    land_migration_singleton migration(_self, _self.value);
+    land_migration current = migration.get_or_default(land_migration{0, false});
+    eosio_assert(!current.done, "Lands have already been migrated");
+
+    // Rows below next_land_id are in the new layout, so the legacy handle never reads them
+    legacy_land_table legacy_lands(_self, _self.value);
+    auto legacy_itr = legacy_lands.lower_bound(current.next_land_id);
+    for(uint32_t rows_migrated = 0; rows_migrated < max_rows && legacy_itr != legacy_lands.end(); rows_migrated++)
+    {
+        legacy_land legacy = *legacy_itr;
+        legacy_itr = legacy_lands.erase(legacy_itr);
+
+        // Legacy edges were validated when registered, they are only snapped to micro degrees
+        auto lands_itr = lands.emplace(_self, [&](auto &row) {
+            row.id = legacy.id;
+            row.owner = legacy.owner;
+            row.lat_north_edge = degrees_to_micro(legacy.lat_north_edge);
+            row.long_east_edge = degrees_to_micro(legacy.long_east_edge);
+            row.lat_south_edge = degrees_to_micro(legacy.lat_south_edge);
+            row.long_west_edge = degrees_to_micro(legacy.long_west_edge);
+            row.reg_end_date = legacy.reg_end_date;
+        });
+        record_upsert("land"_n, _self.value, *lands_itr);
+        current.next_land_id = legacy.id + 1;
+    }
+
+    current.done = legacy_itr == legacy_lands.end();
+    migration.set(current, _self);
+}
+
+void infiniverse::persistpoly(uint64_t land_id, std::string poly_id, compact_transform transform)
 {
     name user = require_land_owner_auth(land_id);
-    assert_vectors_within_bounds(position, orientation, scale);
+    assert_transform_within_bounds(transform);
 
     uint64_t source = static_cast<uint64_t>(PlacementSource::POLY);
-    uint64_t asset_id = add_poly(user, poly_id);
+    uint64_t asset_id = add_poly(user, poly_id, 1);
 
     // Pack the source and asset id into one int to store the composite index
     uint128_t source_and_asset_id = (uint128_t) source << 64 | asset_id;
 
-    persistent_table persistents(_self, _self.value);
-    persistents.emplace(user, [&](auto &row) {
-        row.id = persistents.available_primary_key();
+    uint64_t persistent_id = reserve_persistent_ids(1);
+    persistent_table& persistents = get_persistents(land_id);
+    auto persistents_itr = persistents.emplace(user, [&](auto &row) {
+        row.id = persistent_id;
         row.land_id = land_id;
         row.source_and_asset_id = source_and_asset_id;
-        row.position = position;
-        row.orientation = orientation;
-        row.scale = scale;
+        row.transform = transform;
     });
+    record_upsert("persistent"_n, land_id, *persistents_itr);
+}
+
+void infiniverse::persistpolys(uint64_t land_id, std::vector<placement> placements)
+{
+    name user = require_land_owner_auth(land_id);
+    eosio_assert(!placements.empty(), "No objects to place");
+
+    // Count each distinct poly id so it is looked up, added and counted only once
+    std::unordered_map<std::string, uint64_t> asset_ids;
+    for(const placement& object : placements)
+    {
+        assert_transform_within_bounds(object.transform);
+        asset_ids[object.poly_id]++;
+    }
+
+    for(auto& asset_id : asset_ids)
+    {
+        asset_id.second = add_poly(user, asset_id.first, static_cast<uint32_t>(asset_id.second));
+    }
+
+    uint64_t source = static_cast<uint64_t>(PlacementSource::POLY);
+    persistent_table& persistents = get_persistents(land_id);
+    uint64_t next_id = reserve_persistent_ids(placements.size());
+
+    for(const placement& object : placements)
+    {
+        // Pack the source and asset id into one int to store the composite index
+        uint128_t source_and_asset_id = (uint128_t) source << 64 | asset_ids[object.poly_id];
+
+        auto persistents_itr = persistents.emplace(user, [&](auto &row) {
+            row.id = next_id++;
+            row.land_id = land_id;
+            row.source_and_asset_id = source_and_asset_id;
+            row.transform = object.transform;
+        });
+        record_upsert("persistent"_n, land_id, *persistents_itr);
+    }
 }
 
-void infiniverse::updatepersis(uint64_t persistent_id, uint64_t land_id,
-    vector3 position, vector3 orientation, vector3 scale)
+void infiniverse::updatepersis(uint64_t land_id, uint64_t persistent_id, uint64_t new_land_id,
+    compact_transform transform)
 {
-    persistent_table persistents(_self, _self.value);
+    persistent_table& persistents = get_persistents(land_id);
     auto persistents_itr = persistents.find(persistent_id);
-    uint64_t old_land_id = get_land_id_from_persistent(persistents, persistent_id);
-    require_land_owner_auth(old_land_id);
-    if(land_id != old_land_id)
+    eosio_assert(persistents_itr != persistents.end(), "Persistent Id does not exist");
+    name user = require_land_owner_auth(land_id);
+    assert_transform_within_bounds(transform);
+
+    if(new_land_id == land_id)
     {
-        require_land_owner_auth(land_id);
+        persistents.modify(persistents_itr, same_payer, [&](auto &row) {
+            row.transform = transform;
+        });
+        record_upsert("persistent"_n, land_id, *persistents_itr);
+        return;
     }
-    assert_vectors_within_bounds(position, orientation, scale);
-    persistents.modify(persistents_itr, same_payer, [&](auto &row) {
-        row.land_id = land_id;
-        row.position = position;
-        row.orientation = orientation;
-        row.scale = scale;
+
+    // Moving to another land moves the row to that land's scope, keeping its id
+    require_land_owner_auth(new_land_id);
+    persistent moved = *persistents_itr;
+    persistents.erase(persistents_itr);
+    record_erase("persistent"_n, land_id, persistent_id);
+
+    persistent_table& new_persistents = get_persistents(new_land_id);
+    auto new_persistents_itr = new_persistents.emplace(user, [&](auto &row) {
+        row = moved;
+        row.land_id = new_land_id;
+        row.transform = transform;
     });
+    record_upsert("persistent"_n, new_land_id, *new_persistents_itr);
 }
 
-void infiniverse::deletepersis(uint64_t persistent_id)
+void infiniverse::deletepersis(uint64_t land_id, uint64_t persistent_id)
 {
-    persistent_table persistents(_self, _self.value);
+    persistent_table& persistents = get_persistents(land_id);
     auto persistents_itr = persistents.find(persistent_id);
-    uint64_t land_id = get_land_id_from_persistent(persistents, persistent_id);
-    name user = require_land_owner_auth(land_id);
+    eosio_assert(persistents_itr != persistents.end(), "Persistent Id does not exist");
+    require_land_owner_auth(land_id);
     uint128_t source_and_asset_id = persistents_itr->source_and_asset_id;
     persistents.erase(persistents_itr);
+    record_erase("persistent"_n, land_id, persistent_id);
+    release_asset(source_and_asset_id, true);
+}
 
-    // Get the source by unpacking the most significant bits from the composite index
-    uint64_t source = (uint64_t)(source_and_asset_id >> 64);
-    // If this is a poly asset, we can delete it if the user has not placed it elsewhere
-    if(static_cast<PlacementSource>(source) == PlacementSource::POLY)
+// Moves at most max_rows persistents of a land from the contract's scope into the land's scope, keeping their
+// ids and encoding their float transforms. The land owner signs and pays for the moved rows, as they paid
+// for the legacy ones. Persistents of a land that no longer exists are dropped by the contract account.
+void infiniverse::migratepers(uint64_t land_id, uint32_t max_rows)
+{
+    assert_lands_migrated();
+    eosio_assert(max_rows > 0, "Must allow at least one row to be migrated");
+
+    auto lands_itr = lands.find(land_id);
+    bool land_exists = lands_itr != lands.end();
+    require_auth(land_exists ? lands_itr->owner : _self);
+
+    legacy_persistent_table legacy_persistents(_self, _self.value);
+    auto land_id_index = legacy_persistents.get_index<"bylandid"_n>();
+    auto legacy_itr = land_id_index.lower_bound(land_id);
+    eosio_assert(legacy_itr != land_id_index.end() && legacy_itr->land_id == land_id,
+        "There are no persistents left to migrate");
+
+    persistent_table& persistents = get_persistents(land_id);
+    for(uint32_t rows_migrated = 0; rows_migrated < max_rows && legacy_itr != land_id_index.end()
+        && legacy_itr->land_id == land_id; rows_migrated++)
     {
-        auto asset_id_index = persistents.get_index<"byassetid"_n>();
-        // Asset id is unique per user even if it's the same poly id
-        // Otherwise it would not be clear who should pay for the RAM of a poly object
-        auto itr = asset_id_index.find(source_and_asset_id);
-        if(itr == asset_id_index.end())
+        legacy_persistent legacy = *legacy_itr;
+        legacy_itr = land_id_index.erase(legacy_itr);
+        record_erase("persistent"_n, _self.value, legacy.id);
+
+        if(!land_exists)
+        {
+            release_asset(legacy.source_and_asset_id, false);
+            continue;
+        }
+
+        auto persistents_itr = persistents.emplace(lands_itr->owner, [&](auto &row) {
+            row.id = legacy.id;
+            row.land_id = land_id;
+            row.source_and_asset_id = legacy.source_and_asset_id;
+            row.transform = encode_transform(legacy.position, legacy.orientation, legacy.scale);
+        });
+        record_upsert("persistent"_n, land_id, *persistents_itr);
+        count_migrated_placement(legacy.source_and_asset_id);
+    }
+}
+
+void infiniverse::reaplands(uint32_t max_rows)
+{
+    assert_lands_migrated();
+    eosio_assert(max_rows >= 2, "Must allow at least two rows to be erased, a persistent and its asset");
+
+    auto expiry_index = lands.get_index<"byexpiry"_n>();
+
+    // Lands leave the expiry index as they are erased, so every call resumes at the oldest expired land.
+    // A land is only erased once all of its persistents are, so a partly reaped land is finished next call.
+    uint32_t rows_left = max_rows;
+    auto lands_itr = expiry_index.begin();
+    while(rows_left > 0 && lands_itr != expiry_index.end() && lands_itr->reg_end_date.utc_seconds <= now())
+    {
+        if(!erase_land_persistents(lands_itr->id, rows_left) || rows_left == 0)
         {
-            poly_table poly(_self, _self.value);
-            // Get the asset_id by unpacking the least significant bits from the composite index
-            auto poly_itr = poly.find((uint64_t)source_and_asset_id);
-            poly.erase(poly_itr);
+            break;
         }
+        record_erase("land"_n, _self.value, lands_itr->id);
+        lands_itr = expiry_index.erase(lands_itr);
+        rows_left--;
     }
 
+    eosio_assert(rows_left < max_rows, "There are no expired lands to reap");
+}
+
+// No-op, the change records are read from the action trace by off-chain indexers
+void infiniverse::changes(std::vector<change_record>)
+{
+    require_auth(_self);
+}
+
+// Anyone can flush the accrued registration fees to the token issuer
+void infiniverse::settlefees()
+{
+    fee_accrual_singleton accrual(_self, _self.value);
+    fee_accrual current = accrual.get_or_default(fee_accrual{asset(0, inf_symbol), 0, asset(0, inf_symbol)});
+    eosio_assert(current.accrued.amount > 0, "There are no fees to settle");
+    settle_fees(accrual, current);
+}
+
+// Pays out the RAM surcharges of memo registrations, so the contract account can buy the RAM it pays for
+void infiniverse::withdrawram(name to, asset quantity)
+{
+    require_auth(_self);
+    eosio_assert(quantity.symbol == inf_symbol, "The symbol does not match");
+    eosio_assert(quantity.is_valid(), "The quantity is not valid");
+    eosio_assert(quantity.amount > 0, "The amount must be positive");
+
+    fee_accrual_singleton accrual(_self, _self.value);
+    fee_accrual current = accrual.get_or_default(fee_accrual{asset(0, inf_symbol), 0, asset(0, inf_symbol)});
+    eosio_assert(quantity <= current.ram_reserve, "Withdrawal exceeds the RAM reserve");
+    current.ram_reserve -= quantity;
+    accrual.set(current, _self);
+
+    transfer_inf(_self, to, quantity, "RAM reserve");
 }
 
 void infiniverse::opendeposit(name owner)
 {
     require_auth(owner);
-    deposit_table deposits(_self, _self.value);
     auto deposits_itr = deposits.find(owner.value);
     if(deposits_itr == deposits.end())
     {
@@ -166,7 +436,6 @@ void infiniverse::opendeposit(name owner)
 void infiniverse::closedeposit(name owner)
 {
     require_auth(owner);
-    deposit_table deposits(_self, _self.value);
     auto deposits_itr = deposits.find(owner.value);
     eosio_assert(deposits_itr != deposits.end(), "User does not have a deposit opened");
 
@@ -188,8 +457,33 @@ void infiniverse::depositinf(name from, name to, asset quantity, std::string mem
     eosio_assert(quantity.is_valid(), "The quantity is not valid");
     eosio_assert(quantity.amount > 0, "The amount must be positive");
 
-    deposit_table deposits(_self, _self.value);
     auto deposits_itr = deposits.find(from.value);
+
+    if(memo.compare(0, register_memo_prefix.size(), register_memo_prefix) == 0)
+    {
+        // The transfer pays for the land directly, so no deposit is needed
+        assert_lands_migrated();
+        land_bounds bounds = parse_land_memo(memo.substr(register_memo_prefix.size()));
+        asset inf_amount = get_registration_fee(bounds);
+        eosio_assert(quantity >= inf_amount + memo_land_ram_fee,
+            "Transfer does not cover the registration fee and the land's RAM");
+
+        assert_land_available(bounds);
+        accrue_fee(inf_amount, memo_land_ram_fee);
+        add_land(from, bounds, _self);
+
+        quantity -= inf_amount + memo_land_ram_fee;
+        if(quantity.amount == 0)
+        {
+            return;
+        }
+        if(deposits_itr == deposits.end())
+        {
+            transfer_inf(_self, from, quantity, "");
+            return;
+        }
+    }
+
     eosio_assert(deposits_itr != deposits.end(), "User does not have a deposit opened");
 
     deposits.modify(deposits_itr, same_payer, [&](auto &row){
@@ -197,66 +491,495 @@ void infiniverse::depositinf(name from, name to, asset quantity, std::string mem
     });
 }
 
+// Notified of a token transfermany, every entry paying us is handled like a single transfer
+void infiniverse::depositmany(name from, std::vector<std::pair<name, asset>> transfers, std::string memo)
+{
+    for(const auto& transfer : transfers)
+    {
+        depositinf(from, transfer.first, transfer.second, memo);
+    }
+}
 
-uint64_t infiniverse::get_land_id_from_persistent(const persistent_table& persistents, const uint64_t& persistent_id)
+// Call after erasing a persistent, returns true if its asset was no longer placed anywhere and got erased.
+// Counted is false for legacy persistents, which never added to the reference count.
+bool infiniverse::release_asset(const uint128_t& source_and_asset_id, bool counted)
 {
-    auto persistents_itr = persistents.find(persistent_id);
-    eosio_assert(persistents_itr != persistents.end(), "Persistent Id does not exist");
-    uint64_t land_id = persistents_itr->land_id;
-    return land_id;
+    // Get the source by unpacking the most significant bits from the composite index
+    uint64_t source = (uint64_t)(source_and_asset_id >> 64);
+    // If this is a poly asset, we can delete it if the user has not placed it elsewhere
+    if(static_cast<PlacementSource>(source) != PlacementSource::POLY)
+    {
+        return false;
+    }
+
+    // Get the asset_id by unpacking the least significant bits from the composite index
+    auto poly_itr = polys.find((uint64_t)source_and_asset_id);
+    eosio_assert(poly_itr != polys.end(), "Poly Id does not exist");
+    uint32_t refcount = poly_itr->refcount.value_or(0);
+    if(counted)
+    {
+        refcount--;
+    }
+
+    // Until migratepers has moved every legacy persistent, some placements of the poly may not be counted yet
+    legacy_persistent_table legacy_persistents(_self, _self.value);
+    auto asset_id_index = legacy_persistents.get_index<"byassetid"_n>();
+    if(refcount == 0 && asset_id_index.find(source_and_asset_id) == asset_id_index.end())
+    {
+        record_erase("poly"_n, _self.value, poly_itr->id);
+        if(poly_itr->refcount.has_value())
+        {
+            polys.erase(poly_itr);
+            return true;
+        }
+        // Only the legacy layout knows the row's byuser index entry
+        legacy_poly_table legacy_polys(_self, _self.value);
+        legacy_polys.erase(legacy_polys.find(poly_itr->id));
+        return true;
+    }
+
+    if(counted)
+    {
+        polys.modify(poly_itr, same_payer, [&](auto &row) {
+            row.refcount = refcount;
+        });
+        record_upsert("poly"_n, _self.value, *poly_itr);
+    }
+    return false;
+}
+
+// Counts a persistent moved by migratepers as a placement of its poly
+void infiniverse::count_migrated_placement(const uint128_t& source_and_asset_id)
+{
+    uint64_t source = (uint64_t)(source_and_asset_id >> 64);
+    if(static_cast<PlacementSource>(source) != PlacementSource::POLY)
+    {
+        return;
+    }
+
+    auto poly_itr = polys.find((uint64_t)source_and_asset_id);
+    eosio_assert(poly_itr != polys.end(), "Poly Id does not exist");
+    if(poly_itr->refcount.has_value())
+    {
+        polys.modify(poly_itr, same_payer, [&](auto &row) {
+            row.refcount = row.refcount.value() + 1;
+        });
+        record_upsert("poly"_n, _self.value, *poly_itr);
+        return;
+    }
+
+    // A legacy poly has no byuserpoly entry to update, so it is written again in the current layout,
+    // still paid by its user
+    poly migrated = *poly_itr;
+    migrated.refcount = 1;
+    legacy_poly_table legacy_polys(_self, _self.value);
+    legacy_polys.erase(legacy_polys.find(migrated.id));
+    auto polys_itr = polys.emplace(migrated.user, [&](auto &row) {
+        row = migrated;
+    });
+    record_upsert("poly"_n, _self.value, *polys_itr);
+}
+
+infiniverse::persistent_table& infiniverse::get_persistents(uint64_t land_id)
+{
+    return persistents_by_land.try_emplace(land_id, _self, land_id).first->second;
+}
+
+// Returns the first of count consecutive persistent ids
+uint64_t infiniverse::reserve_persistent_ids(uint64_t count)
+{
+    state_singleton state(_self, _self.value);
+    contract_state current;
+    if(state.exists())
+    {
+        current = state.get();
+    }
+    else
+    {
+        // Migrated persistents keep their legacy ids, so new ids start after the last legacy one
+        legacy_persistent_table legacy_persistents(_self, _self.value);
+        current.next_persistent_id = legacy_persistents.available_primary_key();
+    }
+    uint64_t first_id = current.next_persistent_id;
+    current.next_persistent_id += count;
+    state.set(current, _self);
+    return first_id;
 }
 
 name infiniverse::require_land_owner_auth(const uint64_t& land_id)
 {
-    land_table lands(_self, _self.value);
+    assert_lands_migrated();
     auto lands_itr = lands.find(land_id);
     eosio_assert(lands_itr != lands.end(), "Land Id does not exist");
     require_auth(lands_itr->owner);
     return lands_itr->owner;
 }
 
-void infiniverse::assert_vectors_within_bounds(const vector3& position,
-    const vector3& orientation, const vector3& scale)
+// Every encoded angle and scale is valid, only a zero position falls outside the land
+void infiniverse::assert_transform_within_bounds(const compact_transform& transform)
 {
-    eosio_assert(position.x > 0 && position.y == 0 && position.z > 0 &&
-        position.x < 1 && position.z < 1,
+    eosio_assert(transform.position_x > 0 && transform.position_z > 0,
         "Asset position is not within land bounds");
+}
+
+infiniverse::land_bounds infiniverse::to_land_bounds(double lat_north_edge,
+    double long_east_edge, double lat_south_edge, double long_west_edge)
+{
+    // Temporary longitude limit to between -85 and 85 degrees to simplify display of lands on a mapping UI
+    eosio_assert(lat_north_edge < 85, "Latitude cannot be greater than 85 degrees");
+    eosio_assert(lat_south_edge > -85, "Latitude cannot be less than -85 degrees");
+    eosio_assert(long_east_edge <= 180 && long_east_edge > -180 && long_west_edge <= 180
+        && long_west_edge > -180, "Longitude must be between -180 and 180 degrees");
+
+    // Edges are snapped to whole micro degrees so everything after this point is integer math
+    land_bounds bounds;
+    bounds.lat_north_edge = degrees_to_micro(lat_north_edge);
+    bounds.long_east_edge = degrees_to_micro(long_east_edge);
+    bounds.lat_south_edge = degrees_to_micro(lat_south_edge);
+    bounds.long_west_edge = degrees_to_micro(long_west_edge);
 
-    eosio_assert(orientation.x >= 0 && orientation.x < 360 && orientation.y >= 0 &&
-        orientation.y < 360 && orientation.z >= 0 && orientation.z < 360,
-        "Asset orientation must be within 0 and 360");
+    assert_valid_land_bounds(bounds);
+    return bounds;
+}
 
-    eosio_assert(scale.x >= 0.2 && scale.y >= 0.2 && scale.z >= 0.2, 
-        "Asset scale must be at least 0.2");
+void infiniverse::assert_valid_land_bounds(const land_bounds& bounds)
+{
+    eosio_assert(bounds.lat_north_edge < 85000000, "Latitude cannot be greater than 85 degrees");
+    eosio_assert(bounds.lat_south_edge > -85000000, "Latitude cannot be less than -85 degrees");
+    eosio_assert(bounds.long_east_edge <= 180000000 && bounds.long_east_edge > -180000000
+        && bounds.long_west_edge <= 180000000 && bounds.long_west_edge > -180000000,
+        "Longitude must be between -180 and 180 degrees");
+    eosio_assert(bounds.lat_north_edge > bounds.lat_south_edge,
+        "North edge must have greater latitude than south edge");
+    // Temporary restriction of registering land across the antimeridian to simplify land intersection algorithm
+    eosio_assert(bounds.long_east_edge > bounds.long_west_edge,
+        "East edge must have greater longitude than west edge");
 }
 
-uint64_t infiniverse::add_poly(name user, std::string poly_id)
+// Parses "north,east,south,west" in decimal degrees straight to micro degrees, without going through doubles
+infiniverse::land_bounds infiniverse::parse_land_memo(const std::string& edges)
 {
-    require_auth(user);
+    int32_t micro[4];
+    size_t pos = 0;
+    for(int edge = 0; edge < 4; edge++)
+    {
+        if(edge > 0)
+        {
+            eosio_assert(pos < edges.size() && edges[pos] == ',', "Memo must contain four comma separated edges");
+            pos++;
+        }
+        bool negative = pos < edges.size() && edges[pos] == '-';
+        if(negative)
+        {
+            pos++;
+        }
+
+        int64_t value = 0;
+        int whole_digits = 0;
+        while(pos < edges.size() && edges[pos] >= '0' && edges[pos] <= '9')
+        {
+            eosio_assert(++whole_digits <= 3, "Memo edge is out of range");
+            value = value * 10 + (edges[pos++] - '0');
+        }
+        eosio_assert(whole_digits > 0, "Memo edge is not a number");
+
+        int fraction_digits = 0;
+        if(pos < edges.size() && edges[pos] == '.')
+        {
+            pos++;
+            while(pos < edges.size() && edges[pos] >= '0' && edges[pos] <= '9')
+            {
+                eosio_assert(++fraction_digits <= 6, "Memo edges have at most six decimals");
+                value = value * 10 + (edges[pos++] - '0');
+            }
+        }
+        for(; fraction_digits < 6; fraction_digits++)
+        {
+            value *= 10;
+        }
+        micro[edge] = static_cast<int32_t>(negative ? -value : value);
+    }
+    eosio_assert(pos == edges.size(), "Memo has trailing characters");
+
+    land_bounds bounds{micro[0], micro[1], micro[2], micro[3]};
+    assert_valid_land_bounds(bounds);
+    return bounds;
+}
+
+// Sorts the batch from west to east and checks that none of its lands intersect each other
+void infiniverse::assert_batch_disjoint(std::vector<land_bounds>& batch)
+{
+    eosio_assert(find_intersecting_lands(batch).first == nullptr, "Lands in the batch intersect each other");
+}
+
+// Returns the north south and east west lengths of the land in millimeters
+std::pair<int64_t, int64_t> infiniverse::assert_land_length(const land_bounds& bounds)
+{
+    std::pair<int64_t, int64_t> land_size = lat_long_to_millimeters(bounds.lat_north_edge,
+        bounds.lat_south_edge, bounds.long_east_edge, bounds.long_west_edge);
+
+    eosio_assert(land_size.first <= max_land_length_mm && land_size.second <= max_land_length_mm,
+        ("Land cannot exceed a length of " + std::to_string(max_land_length) + " meters on either side").c_str());
+    return land_size;
+}
+
+// Also enforces the maximum land length since the fee needs the size of the land
+asset infiniverse::get_registration_fee(const land_bounds& bounds)
+{
+    std::pair<int64_t, int64_t> land_size = assert_land_length(bounds);
+
+    // Calculate registration fee assuming each side is at least 1 meter to avoid abuse
+    // Otherwise a malicious user could register a very thin, long and cheap land
+    // This land would be useless but would stop anyone else from registering land over it
+    int64_t land_area_mm2 = std::max<int64_t>(land_size.first, 1000) * std::max<int64_t>(land_size.second, 1000);
+    // Round to the nearest whole INF per square meter
+    int64_t reg_fee = (land_area_mm2 * inf_per_sqm + 500000) / 1000000;
+    // multiply fee by 10000 to account for four decimal places of INF
+    return asset(reg_fee * 10000, inf_symbol);
+}
+
+void infiniverse::charge_deposit(name owner, asset inf_amount)
+{
+    auto deposits_itr = deposits.find(owner.value);
+    eosio_assert(deposits_itr != deposits.end(), "User does not have a deposit opened");
+    eosio_assert(deposits_itr->balance >= inf_amount, "User's INF deposit balance is too low");
+
+    deposits.modify(deposits_itr, same_payer, [&](auto &row){
+        row.balance -= inf_amount;
+    });
+
+    accrue_fee(inf_amount, asset(0, inf_symbol));
+}
 
+// The registration fee is owed to the token issuing account, it stays in our balance
+// until enough charges accrue so registrations don't each send an inline transfer
+void infiniverse::accrue_fee(asset inf_amount, asset ram_amount)
+{
+    fee_accrual_singleton accrual(_self, _self.value);
+    fee_accrual current = accrual.get_or_default(fee_accrual{asset(0, inf_symbol), 0, asset(0, inf_symbol)});
+    current.accrued += inf_amount;
+    current.ram_reserve += ram_amount;
+    current.unsettled_charges++;
+    if(current.unsettled_charges >= charges_per_settlement)
+    {
+        settle_fees(accrual, current);
+        return;
+    }
+    accrual.set(current, _self);
+}
+
+void infiniverse::settle_fees(fee_accrual_singleton& accrual, fee_accrual& current)
+{
+    transfer_inf(_self, inf_account, current.accrued, "");
+    current.accrued.amount = 0;
+    current.unsettled_charges = 0;
+    accrual.set(current, _self);
+}
+
+void infiniverse::add_land(name owner, const land_bounds& bounds, name payer)
+{
+    auto lands_itr = lands.emplace(payer, [&](auto &row) {
+        row.id = lands.available_primary_key();
+        row.owner = owner;
+        row.lat_north_edge = bounds.lat_north_edge;
+        row.long_east_edge = bounds.long_east_edge;
+        row.lat_south_edge = bounds.lat_south_edge;
+        row.long_west_edge = bounds.long_west_edge;
+        row.reg_end_date = time_point_sec(now() + seconds_in_one_year);
+    });
+    record_upsert("land"_n, _self.value, *lands_itr);
+}
+
+// Lands are only read in the micro degree layout once migratelands has rewritten every legacy land
+void infiniverse::assert_lands_migrated()
+{
+    land_migration_singleton migration(_self, _self.value);
+    if(migration.get_or_default(land_migration{0, false}).done)
+    {
+        return;
+    }
+    // A new deployment has no legacy lands, so it is migrated from the start
+    eosio_assert(!migration.exists() && lands.begin() == lands.end(), "Lands must be migrated with migratelands first");
+    migration.set(land_migration{0, true}, _self);
+}
+
+// Expired lands in the way are reclaimed, any other intersecting land rejects the registration
+void infiniverse::assert_land_available(const land_bounds& bounds)
+{
+    // Lands are keyed by their south west corner, so an intersecting land has its corner
+    // at most one maximum land length south or west of the new land
+    int32_t lat_south_bound = bounds.lat_south_edge - millimeters_to_lat_span(max_land_length_mm);
+    int32_t long_west_bound = bounds.long_west_edge - millimeters_to_long_span(max_land_length_mm,
+        bounds.lat_north_edge, bounds.lat_south_edge);
+
+    // Lands are erased after the walk since erasing would invalidate its iterator
+    std::vector<uint64_t> expired_land_ids;
+    for_each_land_in_box(bounds.lat_north_edge, bounds.long_east_edge, lat_south_bound, long_west_bound,
+        [&](const land& existing_land) {
+            if(lands_intersect(existing_land, bounds))
+            {
+                assert_expired(existing_land);
+                expired_land_ids.push_back(existing_land.id);
+            }
+        });
+    reclaim_lands(expired_land_ids);
+}
+
+void infiniverse::assert_expired(const land& existing_land)
+{
+    eosio_assert(existing_land.reg_end_date.utc_seconds <= now(), "Intersecting land has already been registered");
+}
+
+void infiniverse::reclaim_lands(const std::vector<uint64_t>& land_ids)
+{
+    uint32_t rows_left = max_reclaimed_rows;
+    for(uint64_t land_id : land_ids)
+    {
+        eosio_assert(erase_land_persistents(land_id, rows_left) && rows_left > 0,
+            "Intersecting expired land has too many objects, reap it with reaplands first");
+        record_erase("land"_n, _self.value, land_id);
+        lands.erase(lands.find(land_id));
+        rows_left--;
+    }
+}
+
+// Erases a land's persistents and releases their assets within the row budget, true once none are left.
+// A persistent is only erased while the budget also covers releasing its asset.
+bool infiniverse::erase_land_persistents(uint64_t land_id, uint32_t& rows_left)
+{
+    persistent_table& persistents = get_persistents(land_id);
+    auto persistents_itr = persistents.begin();
+    while(rows_left >= 2 && persistents_itr != persistents.end())
+    {
+        uint128_t source_and_asset_id = persistents_itr->source_and_asset_id;
+        record_erase("persistent"_n, land_id, persistents_itr->id);
+        persistents_itr = persistents.erase(persistents_itr);
+        rows_left--;
+        if(release_asset(source_and_asset_id, true))
+        {
+            rows_left--;
+        }
+    }
+    return persistents_itr == persistents.end();
+}
+
+// Visits every land whose south west corner lies within the given box
+template<typename F>
+void infiniverse::for_each_land_in_box(int32_t lat_north, int32_t long_east,
+    int32_t lat_south, int32_t long_west, F&& visit)
+{
+    uint64_t z_min = z_order_encode(long_to_z_coord(long_west), lat_to_z_coord(lat_south));
+    uint64_t z_max = z_order_encode(long_to_z_coord(long_east), lat_to_z_coord(lat_north));
+
+    auto z_order_index = lands.get_index<"byzorder"_n>();
+    auto lands_itr = z_order_index.lower_bound(z_min);
+    while(lands_itr != z_order_index.end())
+    {
+        uint64_t z_value = lands_itr->get_z_order_key();
+        if(z_value > z_max)
+        {
+            break;
+        }
+        if(z_order_in_box(z_value, z_min, z_max))
+        {
+            visit(*lands_itr);
+            lands_itr++;
+        }
+        else
+        {
+            // Skip over the run of keys that lies outside the box
+            lands_itr = z_order_index.lower_bound(z_order_next_in_box(z_value, z_min, z_max));
+        }
+    }
+}
+
+uint128_t infiniverse::poly::get_user_and_poly_hash() const
+{
+    return infiniverse::get_user_and_poly_hash(user, poly_id);
+}
+
+uint64_t infiniverse::land::get_z_order_key() const
+{
+    return z_order_encode(long_to_z_coord(long_west_edge), lat_to_z_coord(lat_south_edge));
+}
+
+uint128_t infiniverse::get_user_and_poly_hash(name user, const std::string& poly_id)
+{
+    return user_and_poly_hash(user.value, poly_id);
+}
+
+// Counts placements new references to the poly. Callers must already have required the user's authority
+uint64_t infiniverse::add_poly(name user, const std::string& poly_id, uint32_t placements)
+{
     eosio_assert((poly_id.length() == 11), "Poly Id format is invalid");
 
-    poly_table poly(_self, _self.value);
-    auto user_index = poly.get_index<"byuser"_n>();
-    auto poly_itr = user_index.find(user.value);
-    while(poly_itr != user_index.end() && poly_itr->user == user)
+    uint128_t user_and_poly_hash = get_user_and_poly_hash(user, poly_id);
+    auto user_poly_index = polys.get_index<"byuserpoly"_n>();
+    auto poly_itr = user_poly_index.find(user_and_poly_hash);
+    // Different poly ids can share a hash, so confirm the id itself
+    while(poly_itr != user_poly_index.end() && poly_itr->get_user_and_poly_hash() == user_and_poly_hash)
     {
+        // Legacy polys have no byuserpoly entry, so every poly found here has a count
         if(poly_itr->poly_id == poly_id)
         {
+            user_poly_index.modify(poly_itr, same_payer, [&](auto &row) {
+                row.refcount = row.refcount.value() + placements;
+            });
+            record_upsert("poly"_n, _self.value, *poly_itr);
             return poly_itr->id;
         }
         poly_itr++;
     }
 
-    uint64_t new_id = poly.available_primary_key();
-    poly.emplace(user, [&](auto &row) {
+    uint64_t new_id = polys.available_primary_key();
+    auto polys_itr = polys.emplace(user, [&](auto &row) {
         row.id = new_id;
         row.user = user;
         row.poly_id = poly_id;
+        row.refcount = placements;
     });
+    record_upsert("poly"_n, _self.value, *polys_itr);
     return new_id;
 }
 
+// Publishes every change the action made as one inline changes action
+infiniverse::~infiniverse()
+{
+    auto send_changes = [&](const std::vector<change_record>& records) {
+        action{
+            permission_level{_self, "active"_n},
+            _self,
+            "changes"_n,
+            std::make_tuple(records)
+        }.send();
+    };
+
+    // Records are sent in order, split so that no action exceeds the inline action size limit
+    std::vector<change_record> records;
+    size_t records_bytes = 0;
+    for(change_record& record : pending_changes)
+    {
+        size_t record_bytes = pack_size(record);
+        if(!records.empty() && records_bytes + record_bytes > max_changes_action_bytes)
+        {
+            send_changes(records);
+            records.clear();
+            records_bytes = 0;
+        }
+        records_bytes += record_bytes;
+        records.push_back(std::move(record));
+    }
+    if(!records.empty())
+    {
+        send_changes(records);
+    }
+}
+
+void infiniverse::record_erase(name table, uint64_t scope, uint64_t id)
+{
+    pending_changes.push_back(change_record{static_cast<uint8_t>(ChangeOp::ERASE), table, scope, id, {}});
+}
+
 // This function requires giving the active permission to the eosio.code permission
 // cleos set account permission infiniverse1 active '{"threshold": 1,"keys": [{"key": "ACTIVE PUBKEY","weight": 1}],"accounts": [{"permission":{"actor":"infiniverse1","permission":"eosio.code"},"weight":1}]}' owner -p infiniverse1@owner
 void infiniverse::transfer_inf(name from, name to, asset quantity, std::string memo)
@@ -275,11 +998,29 @@ extern "C" {
         {
             switch(action)
             {
-                EOSIO_DISPATCH_HELPER( infiniverse, (registerland)(persistpoly)(updatepersis)(deletepersis)(opendeposit)(closedeposit) )
+                EOSIO_DISPATCH_HELPER( infiniverse, (registerland)(registerlands)(renewlands)(importlands)(migratelands)(persistpoly)(persistpolys)(updatepersis)(deletepersis)(migratepers)(reaplands)(settlefees)(withdrawram)(changes)(opendeposit)(closedeposit) )
             }
         }
         else if(code==inf_account.value && action=="transfer"_n.value) {
+            // Transfer data starts with the from and to names, read only those so notifications for
+            // transfers that don't pay us are dropped before the asset and memo are unpacked
+            uint64_t from_and_to[2];
+            if(action_data_size() < sizeof(from_and_to))
+                return;
+            read_action_data(from_and_to, sizeof(from_and_to));
+            if(from_and_to[0] == receiver || from_and_to[1] != receiver)
+                return;
             execute_action( name(receiver), name(code), &infiniverse::depositinf );
         }
+        else if(code==inf_account.value && action=="transfermany"_n.value) {
+            // We are notified as a recipient, the sender's own notification is dropped
+            uint64_t from;
+            if(action_data_size() < sizeof(from))
+                return;
+            read_action_data(&from, sizeof(from));
+            if(from == receiver)
+                return;
+            execute_action( name(receiver), name(code), &infiniverse::depositmany );
+        }
     }
 };
\ No newline at end of file
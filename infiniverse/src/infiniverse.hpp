@@ -1,6 +1,14 @@
 #include <eosiolib/eosio.hpp>
 #include <eosiolib/asset.hpp>
 #include <eosiolib/time.hpp>
+#include <eosiolib/singleton.hpp>
+#include <eosiolib/binary_extension.hpp>
+
+#include <map>
+#include <unordered_map>
+
+#include "transform_encoding.hpp"
+#include "user_poly_hash.hpp"
 
 using namespace eosio;
 
@@ -10,22 +18,69 @@ CONTRACT infiniverse : public contract
 
     using contract::contract;
 
-    struct vector3 {
-        float x;
-        float y;
-        float z;
+    // Sends the inline changes actions with every row change the action made. It runs when
+    // dispatch destroys the contract object, after the action handler has returned
+    ~infiniverse();
+
+    struct land_rect {
+        double lat_north_edge;
+        double long_east_edge;
+        double lat_south_edge;
+        double long_west_edge;
+    };
+
+    // Edges in signed micro degrees
+    struct imported_land {
+        name owner;
+        int32_t lat_north_edge;
+        int32_t long_east_edge;
+        int32_t lat_south_edge;
+        int32_t long_west_edge;
+    };
+
+    // One row change, row holds the packed row after an upsert and is empty after an erase
+    struct change_record {
+        uint8_t op;
+        name table;
+        uint64_t scope;
+        uint64_t id;
+        std::vector<char> row;
+    };
+
+    struct placement {
+        std::string poly_id;
+        compact_transform transform;
     };
 
     ACTION registerland(name owner, double lat_north_edge,
         double long_east_edge, double lat_south_edge, double long_west_edge);
 
-    ACTION persistpoly(uint64_t land_id, std::string poly_id,
-        vector3 position, vector3 orientation, vector3 scale);
+    ACTION registerlands(name owner, std::vector<land_rect> rects);
+
+    ACTION renewlands(name owner, std::vector<uint64_t> land_ids, uint32_t years);
+
+    ACTION importlands(std::vector<imported_land> imports);
+
+    ACTION migratelands(uint32_t max_rows);
+
+    ACTION persistpoly(uint64_t land_id, std::string poly_id, compact_transform transform);
+
+    ACTION persistpolys(uint64_t land_id, std::vector<placement> placements);
+
+    ACTION updatepersis(uint64_t land_id, uint64_t persistent_id, uint64_t new_land_id,
+        compact_transform transform);
+
+    ACTION deletepersis(uint64_t land_id, uint64_t persistent_id);
+
+    ACTION migratepers(uint64_t land_id, uint32_t max_rows);
 
-    ACTION updatepersis(uint64_t persistent_id, uint64_t land_id,
-        vector3 position, vector3 orientation, vector3 scale);
+    ACTION reaplands(uint32_t max_rows);
 
-    ACTION deletepersis(uint64_t persistent_id);
+    ACTION settlefees();
+
+    ACTION withdrawram(name to, asset quantity);
+
+    ACTION changes(std::vector<change_record> records);
 
     ACTION opendeposit(name owner);
 
@@ -33,6 +88,8 @@ CONTRACT infiniverse : public contract
 
     ACTION depositinf(name from, name to, asset quantity, std::string memo);
 
+    ACTION depositmany(name from, std::vector<std::pair<name, asset>> transfers, std::string memo);
+
     private:
 
     enum class PlacementSource : uint64_t
@@ -42,7 +99,46 @@ CONTRACT infiniverse : public contract
         INVALID_MAX
     };
 
+    enum class ChangeOp : uint8_t
+    {
+        UPSERT,
+        ERASE
+    };
+
+    // Validated land edges in signed micro degrees
+    struct land_bounds {
+        int32_t lat_north_edge;
+        int32_t long_east_edge;
+        int32_t lat_south_edge;
+        int32_t long_west_edge;
+    };
+
+    // Edges are stored in signed micro degrees
     TABLE land
+    {
+        uint64_t id;
+        name owner;
+        int32_t lat_north_edge;
+        int32_t long_east_edge;
+        int32_t lat_south_edge;
+        int32_t long_west_edge;
+        time_point_sec reg_end_date;
+
+        uint64_t primary_key() const { return id; }
+        uint64_t get_name() const { return owner.value; }
+        uint64_t get_reg_end_date() const { return reg_end_date.utc_seconds; }
+        // Z-order key of the south west corner, prunes spatial queries in both dimensions
+        uint64_t get_z_order_key() const;
+    };
+
+    typedef multi_index<"land"_n, land,
+        indexed_by<"byowner"_n, const_mem_fun<land, uint64_t, &land::get_name>>,
+        indexed_by<"byzorder"_n, const_mem_fun<land, uint64_t, &land::get_z_order_key>>,
+        indexed_by<"byexpiry"_n, const_mem_fun<land, uint64_t, &land::get_reg_end_date>>>
+        land_table;
+
+    // Land rows written when edges were stored as doubles, only read by migratelands
+    TABLE legacy_land
     {
         uint64_t id;
         name owner;
@@ -60,15 +156,42 @@ CONTRACT infiniverse : public contract
         double get_long_west_edge() const { return long_west_edge; }
     };
 
-    typedef multi_index<"land"_n, land,
-        indexed_by<"byowner"_n, const_mem_fun<land, uint64_t, &land::get_name>>,
-        indexed_by<"bylatnorth"_n, const_mem_fun<land, double, &land::get_lat_north_edge>>,
-        indexed_by<"bylongeast"_n, const_mem_fun<land, double, &land::get_long_east_edge>>,
-        indexed_by<"bylatsouth"_n, const_mem_fun<land, double, &land::get_lat_south_edge>>,
-        indexed_by<"bylongwest"_n, const_mem_fun<land, double, &land::get_long_west_edge>>>
-        land_table;
+    typedef multi_index<"land"_n, legacy_land,
+        indexed_by<"byowner"_n, const_mem_fun<legacy_land, uint64_t, &legacy_land::get_name>>,
+        indexed_by<"bylatnorth"_n, const_mem_fun<legacy_land, double, &legacy_land::get_lat_north_edge>>,
+        indexed_by<"bylongeast"_n, const_mem_fun<legacy_land, double, &legacy_land::get_long_east_edge>>,
+        indexed_by<"bylatsouth"_n, const_mem_fun<legacy_land, double, &legacy_land::get_lat_south_edge>>,
+        indexed_by<"bylongwest"_n, const_mem_fun<legacy_land, double, &legacy_land::get_long_west_edge>>>
+        legacy_land_table;
+
+    // Lands with ids below next_land_id have been rewritten in the micro degree layout
+    TABLE land_migration {
+        uint64_t next_land_id;
+        bool done;
+    };
+
+    typedef singleton<"landmigrate"_n, land_migration> land_migration_singleton;
     
     TABLE persistent {
+        uint64_t id;
+        uint64_t land_id;
+        uint128_t source_and_asset_id;
+        compact_transform transform;
+
+        uint64_t primary_key() const { return id; }
+    };
+
+    // Persistents are scoped by their land id so a land's scene is one small table
+    typedef multi_index<"persistent"_n, persistent> persistent_table;
+
+    struct vector3 {
+        float x;
+        float y;
+        float z;
+    };
+
+    // Persistents written before they were scoped by land, all in the contract's scope until migratepers moves them
+    TABLE legacy_persistent {
         uint64_t id;
         uint64_t land_id;
         uint128_t source_and_asset_id;
@@ -81,24 +204,42 @@ CONTRACT infiniverse : public contract
         uint128_t get_source_and_asset_id() const { return source_and_asset_id; }
     };
 
-    typedef multi_index<"persistent"_n, persistent,
-        indexed_by<"bylandid"_n, const_mem_fun<persistent, uint64_t, &persistent::get_land_id>>,
-        indexed_by<"byassetid"_n, const_mem_fun<persistent, uint128_t, &persistent::get_source_and_asset_id>>>
-        persistent_table;
+    typedef multi_index<"persistent"_n, legacy_persistent,
+        indexed_by<"bylandid"_n, const_mem_fun<legacy_persistent, uint64_t, &legacy_persistent::get_land_id>>,
+        indexed_by<"byassetid"_n, const_mem_fun<legacy_persistent, uint128_t, &legacy_persistent::get_source_and_asset_id>>>
+        legacy_persistent_table;
 
     TABLE poly {
         uint64_t id;
         name user;
         std::string poly_id;
+        // Number of persistents placing this poly, the poly is erased when it drops to zero.
+        // Only legacy polys that migratepers has not rewritten yet have no value
+        binary_extension<uint32_t> refcount;
 
         uint64_t primary_key() const { return id; }
-        uint64_t get_user() const { return user.value; }
+        // User in the high bits so a user's polys stay contiguous, poly id hash in the low bits
+        uint128_t get_user_and_poly_hash() const;
     };
 
     typedef multi_index<"poly"_n, poly,
-        indexed_by<"byuser"_n, const_mem_fun<poly, uint64_t, &poly::get_user>>>
+        indexed_by<"byuserpoly"_n, const_mem_fun<poly, uint128_t, &poly::get_user_and_poly_hash>>>
         poly_table;
 
+    // Polys written before the byuserpoly index, they have no refcount until migratepers rewrites them
+    TABLE legacy_poly {
+        uint64_t id;
+        name user;
+        std::string poly_id;
+
+        uint64_t primary_key() const { return id; }
+        uint64_t get_user() const { return user.value; }
+    };
+
+    typedef multi_index<"poly"_n, legacy_poly,
+        indexed_by<"byuser"_n, const_mem_fun<legacy_poly, uint64_t, &legacy_poly::get_user>>>
+        legacy_poly_table;
+
     TABLE deposit {
         name owner;
         asset balance;
@@ -107,15 +248,94 @@ CONTRACT infiniverse : public contract
     };
 
     typedef eosio::multi_index<"deposit"_n, deposit> deposit_table;
-    
 
-    uint64_t add_poly(name user, std::string poly_id);
+    TABLE contract_state {
+        // Persistent ids stay unique across land scopes so objects keep their id when moved
+        uint64_t next_persistent_id;
+    };
+
+    typedef singleton<"state"_n, contract_state> state_singleton;
+
+    // Registration fees owed to the token issuer, flushed in one transfer by settlefees.
+    // ram_reserve is never settled, it is what memo registrants paid for the land rows we pay RAM for,
+    // withdrawn by the contract account with withdrawram to buy that RAM
+    TABLE fee_accrual {
+        asset accrued;
+        uint32_t unsettled_charges;
+        asset ram_reserve;
+    };
+
+    typedef singleton<"feeaccrual"_n, fee_accrual> fee_accrual_singleton;
+
+    // Table handles live for the whole action and multi_index keeps every row it has read,
+    // so helpers sharing these handles read each row from the database at most once
+    land_table lands{_self, _self.value};
+    poly_table polys{_self, _self.value};
+    deposit_table deposits{_self, _self.value};
+    std::map<uint64_t, persistent_table> persistents_by_land;
+
+    persistent_table& get_persistents(uint64_t land_id);
+
+    // Row changes made by this action, sent to indexers in changes actions when it completes
+    std::vector<change_record> pending_changes;
+
+    template<typename T>
+    void record_upsert(name table, uint64_t scope, const T& row)
+    {
+        pending_changes.push_back(change_record{static_cast<uint8_t>(ChangeOp::UPSERT), table, scope,
+            row.primary_key(), pack(row)});
+    }
+
+    void record_erase(name table, uint64_t scope, uint64_t id);
+
+    static uint128_t get_user_and_poly_hash(name user, const std::string& poly_id);
+
+    uint64_t add_poly(name user, const std::string& poly_id, uint32_t placements);
+
+    uint64_t reserve_persistent_ids(uint64_t count);
+
+    land_bounds to_land_bounds(double lat_north_edge, double long_east_edge,
+        double lat_south_edge, double long_west_edge);
+
+    void assert_valid_land_bounds(const land_bounds& bounds);
+
+    land_bounds parse_land_memo(const std::string& edges);
+
+    void assert_batch_disjoint(std::vector<land_bounds>& batch);
+
+    std::pair<int64_t, int64_t> assert_land_length(const land_bounds& bounds);
+
+    asset get_registration_fee(const land_bounds& bounds);
+
+    void charge_deposit(name owner, asset inf_amount);
+
+    void accrue_fee(asset inf_amount, asset ram_amount);
+
+    void settle_fees(fee_accrual_singleton& accrual, fee_accrual& current);
+
+    void add_land(name owner, const land_bounds& bounds, name payer);
+
+    void assert_lands_migrated();
+
+    void assert_land_available(const land_bounds& bounds);
+
+    void assert_expired(const land& existing_land);
+
+    void reclaim_lands(const std::vector<uint64_t>& land_ids);
+
+    bool erase_land_persistents(uint64_t land_id, uint32_t& rows_left);
+
+    template<typename F>
+    void for_each_land_in_box(int32_t lat_north, int32_t long_east,
+        int32_t lat_south, int32_t long_west, F&& visit);
+
+    bool release_asset(const uint128_t& source_and_asset_id, bool counted);
 
-    uint64_t get_land_id_from_persistent(const persistent_table& persistents, const uint64_t& persistent_id);
+    void count_migrated_placement(const uint128_t& source_and_asset_id);
 
     name require_land_owner_auth(const uint64_t& land_id);
 
-    void assert_vectors_within_bounds(const vector3& position, const vector3& orientation, const vector3& scale);
+    void assert_transform_within_bounds(const compact_transform& transform);
 
     void transfer_inf(name from, name to, asset quantity, std::string memo);
 };
\ No newline at end of file
@@ -1,27 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <utility>
+#include <vector>
+
+const int64_t meters_per_degree_latitude = 111133;
+const int64_t meters_per_degree_longitude_equator = 111320;
+const double micro_degrees_per_degree = 1000000;
+const int64_t micro_degrees_in_one_degree = 1000000;
 
-const double meters_per_degree_latitude = 111133;
-const double meters_per_degree_longitude_equator = 111320;
+// Cosine of latitude is looked up in quarter degree bands and linearly interpolated.
+// The interpolation error is below 3e-6 and the fixed point step is 1e-6, so with the
+// integer truncations a 100 meter length stays within 3 millimeters of the double math.
+const int64_t cos_band_micro_degrees = 250000;
+const int cos_table_size = 90 * 4 + 1;
+const int cos_fraction_bits = 20;
+const int64_t cos_one = (int64_t)1 << cos_fraction_bits;
+
+// Only ever evaluated by the compiler to build cos_table, so no floating point reaches the contract
+constexpr double constexpr_cos(double radians)
+{
+    double term = 1;
+    double sum = 1;
+    for(int n = 1; n < 16; n++)
+    {
+        term *= -radians * radians / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
 
-std::pair<double, double> lat_long_to_meters(const double& lat1, const double& lat2,
-    const double& long1, const double& long2)
+constexpr std::array<int64_t, cos_table_size> make_cos_table()
 {
-    double average_lat_radians = (lat1 + lat2)/2 * M_PI / 180;
-    double lat_difference = abs(lat1 - lat2);
-    double long_difference = abs(long1 - long2);
-    double lat_distance_meters = lat_difference * meters_per_degree_latitude;
-    double long_distance_meters = long_difference * meters_per_degree_longitude_equator * cos(average_lat_radians);
-    return std::pair<double, double>(lat_distance_meters, long_distance_meters);
+    std::array<int64_t, cos_table_size> table{};
+    for(int band = 0; band < cos_table_size; band++)
+    {
+        double radians = band * 3.14159265358979323846 / 180 / 4;
+        table[band] = static_cast<int64_t>(constexpr_cos(radians) * cos_one + 0.5);
+    }
+    return table;
 }
 
-double meters_to_lat_dist(const double& lat_distance_meters)
+constexpr std::array<int64_t, cos_table_size> cos_table = make_cos_table();
+
+static_assert(cos_table[0] == cos_one, "cos(0) must be exactly one");
+static_assert(cos_table[60 * 4] == cos_one / 2, "cos(60) must be exactly one half");
+static_assert(cos_table[90 * 4] == 0, "cos(90) must be exactly zero");
+
+// Cosine of a latitude in micro degrees, with cos_fraction_bits of fraction
+inline int64_t fixed_cos_lat(int64_t lat)
 {
-    return lat_distance_meters / meters_per_degree_latitude;
+    lat = std::min<int64_t>(std::abs(lat), 90 * micro_degrees_in_one_degree);
+    int64_t band = lat / cos_band_micro_degrees;
+    int64_t offset = lat % cos_band_micro_degrees;
+    if(band == cos_table_size - 1)
+    {
+        return cos_table[band];
+    }
+    return cos_table[band] + (cos_table[band + 1] - cos_table[band]) * offset / cos_band_micro_degrees;
 }
 
-double meters_to_long_dist(const double& long_distance_meters, const double& lat1, const double& lat2)
+// Returns the north-south and east-west lengths in millimeters of a rectangle with edges in micro degrees
+inline std::pair<int64_t, int64_t> lat_long_to_millimeters(const int32_t& lat1, const int32_t& lat2,
+    const int32_t& long1, const int32_t& long2)
 {
-    double average_lat_radians = (lat1 + lat2)/2 * M_PI / 180;
-    return long_distance_meters / meters_per_degree_longitude_equator / cos(average_lat_radians);
-}
\ No newline at end of file
+    int64_t average_lat = ((int64_t)lat1 + lat2) / 2;
+    int64_t lat_difference = std::abs((int64_t)lat1 - lat2);
+    int64_t long_difference = std::abs((int64_t)long1 - long2);
+    int64_t lat_distance_millimeters = lat_difference * meters_per_degree_latitude / 1000;
+    int64_t long_distance_millimeters = (long_difference * meters_per_degree_longitude_equator / 1000)
+        * fixed_cos_lat(average_lat) >> cos_fraction_bits;
+    return std::pair<int64_t, int64_t>(lat_distance_millimeters, long_distance_millimeters);
+}
+
+// Latitude span in micro degrees covered by the given distance, rounded up
+inline int32_t millimeters_to_lat_span(const int64_t& lat_distance_millimeters)
+{
+    return static_cast<int32_t>((lat_distance_millimeters * 1000 + meters_per_degree_latitude - 1)
+        / meters_per_degree_latitude);
+}
+
+// Longitude span in micro degrees covered by the given distance anywhere near the given latitudes, rounded up
+inline int32_t millimeters_to_long_span(const int64_t& long_distance_millimeters, const int32_t& lat1, const int32_t& lat2)
+{
+    // Degrees of longitude are shortest at the latitude closest to a pole that a land this long could reach
+    int32_t lat_span = millimeters_to_lat_span(long_distance_millimeters);
+    int64_t poleward_lat = std::max(std::abs(lat1), std::abs(lat2)) + lat_span;
+    // Take one off the cosine so the truncation in fixed_cos_lat can only make the span larger
+    int64_t cos_lat = std::max<int64_t>(fixed_cos_lat(poleward_lat) - 1, 1);
+    int64_t divisor = meters_per_degree_longitude_equator * cos_lat;
+    // One extra micro degree covers the truncation in lat_long_to_millimeters
+    return static_cast<int32_t>(((long_distance_millimeters * 1000 << cos_fraction_bits) + divisor - 1) / divisor) + 1;
+}
+
+// Callers must have range checked the degrees, converting out of range doubles is undefined
+inline int32_t degrees_to_micro(const double& degrees)
+{
+    return static_cast<int32_t>(round(degrees * micro_degrees_per_degree));
+}
+
+// Works for any two rectangles with edges in micro degrees, touching edges do not intersect
+template<typename A, typename B>
+bool lands_intersect(const A& a, const B& b)
+{
+    return a.long_east_edge > b.long_west_edge && a.long_west_edge < b.long_east_edge &&
+        a.lat_north_edge > b.lat_south_edge && a.lat_south_edge < b.lat_north_edge;
+}
+
+// Sorts the lands by west edge and sweeps them from west to east, only lands still open in longitude can
+// intersect the next one. Returns the first intersecting pair found, or two null pointers if none intersect
+template<typename Land>
+std::pair<const Land*, const Land*> find_intersecting_lands(std::vector<Land>& lands)
+{
+    std::sort(lands.begin(), lands.end(), [](const Land& a, const Land& b) {
+        return a.long_west_edge < b.long_west_edge;
+    });
+    std::vector<const Land*> open_lands;
+    for(const Land& land : lands)
+    {
+        open_lands.erase(std::remove_if(open_lands.begin(), open_lands.end(), [&](const Land* open_land) {
+            return open_land->long_east_edge <= land.long_west_edge;
+        }), open_lands.end());
+        for(const Land* open_land : open_lands)
+        {
+            if(lands_intersect(*open_land, land))
+                return {open_land, &land};
+        }
+        open_lands.push_back(&land);
+    }
+    return {nullptr, nullptr};
+}
+
+// Offset coordinates so they are unsigned and keep their order in a z-order key
+inline uint32_t lat_to_z_coord(const int32_t& lat)
+{
+    return static_cast<uint32_t>(std::max(lat + 90 * 1000000, 0));
+}
+
+inline uint32_t long_to_z_coord(const int32_t& lng)
+{
+    return static_cast<uint32_t>(std::max(lng + 180 * 1000000, 0));
+}
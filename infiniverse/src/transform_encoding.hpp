@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Compact transform of a placed object, shared by the contract and its clients.
+// The contract only stores and range checks the encoded values. Clients convert
+// to and from floats with encode_transform and decode_transform.
+//
+// Position x and z are fractions of the land in (0, 1) with 16 bits of precision.
+// Position y is always 0 and is not stored.
+// Angles are degrees in [0, 360) with 16 bits of precision.
+// Scale is stored as 4096 steps per doubling above the minimum scale of 0.2.
+struct compact_transform {
+    uint16_t position_x;
+    uint16_t position_z;
+    uint16_t orientation_x;
+    uint16_t orientation_y;
+    uint16_t orientation_z;
+    uint16_t scale_x;
+    uint16_t scale_y;
+    uint16_t scale_z;
+};
+
+const double transform_position_steps = 65536;
+const double transform_angle_steps = 65536;
+const double transform_min_scale = 0.2;
+const double transform_scale_steps_per_doubling = 4096;
+
+inline uint16_t encode_position(double position)
+{
+    // Zero is reserved as out of bounds, so clamp to the first and last representable steps
+    double steps = std::round(position * transform_position_steps);
+    return static_cast<uint16_t>(std::fmin(std::fmax(steps, 1), transform_position_steps - 1));
+}
+
+inline double decode_position(uint16_t position)
+{
+    return position / transform_position_steps;
+}
+
+inline uint16_t encode_angle(double degrees)
+{
+    double steps = std::round(std::fmod(degrees, 360) * transform_angle_steps / 360);
+    if(steps < 0)
+    {
+        steps += transform_angle_steps;
+    }
+    return static_cast<uint16_t>(static_cast<uint32_t>(steps) % 65536);
+}
+
+inline double decode_angle(uint16_t angle)
+{
+    return angle * 360 / transform_angle_steps;
+}
+
+inline uint16_t encode_scale(double scale)
+{
+    double steps = std::round(std::log2(scale / transform_min_scale) * transform_scale_steps_per_doubling);
+    return static_cast<uint16_t>(std::fmin(std::fmax(steps, 0), 65535));
+}
+
+inline double decode_scale(uint16_t scale)
+{
+    return transform_min_scale * std::exp2(scale / transform_scale_steps_per_doubling);
+}
+
+// Works with any vector type that has x, y and z members
+template<typename V>
+compact_transform encode_transform(const V& position, const V& orientation, const V& scale)
+{
+    compact_transform transform;
+    transform.position_x = encode_position(position.x);
+    transform.position_z = encode_position(position.z);
+    transform.orientation_x = encode_angle(orientation.x);
+    transform.orientation_y = encode_angle(orientation.y);
+    transform.orientation_z = encode_angle(orientation.z);
+    transform.scale_x = encode_scale(scale.x);
+    transform.scale_y = encode_scale(scale.y);
+    transform.scale_z = encode_scale(scale.z);
+    return transform;
+}
+
+template<typename V>
+void decode_transform(const compact_transform& transform, V& position, V& orientation, V& scale)
+{
+    position.x = decode_position(transform.position_x);
+    position.y = 0;
+    position.z = decode_position(transform.position_z);
+    orientation.x = decode_angle(transform.orientation_x);
+    orientation.y = decode_angle(transform.orientation_y);
+    orientation.z = decode_angle(transform.orientation_z);
+    scale.x = decode_scale(transform.scale_x);
+    scale.y = decode_scale(transform.scale_y);
+    scale.z = decode_scale(transform.scale_z);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Key of the poly table's byuserpoly index, shared by the contract and its clients.
+// The user is in the high bits so a user's polys stay contiguous, the poly id hash in the low bits.
+inline unsigned __int128 user_and_poly_hash(uint64_t user, const std::string& poly_id)
+{
+    // 64 bit FNV-1a, cheap in WASM and only needs to spread the ids of a single user
+    uint64_t hash = 14695981039346656037ull;
+    for(const char& c : poly_id)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return (unsigned __int128) user << 64 | hash;
+}
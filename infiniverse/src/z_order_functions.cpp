@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+// Z-order (Morton) keys interleave the bits of two unsigned coordinates,
+// x on the even bits and y on the odd bits, so that points close together
+// in both dimensions tend to be close together in key order.
+const uint64_t z_even_bits = 0x5555555555555555;
+const uint64_t z_odd_bits = 0xAAAAAAAAAAAAAAAA;
+
+inline uint64_t spread_bits(uint32_t value)
+{
+    uint64_t spread = value;
+    spread = (spread | spread << 16) & 0x0000FFFF0000FFFF;
+    spread = (spread | spread << 8) & 0x00FF00FF00FF00FF;
+    spread = (spread | spread << 4) & 0x0F0F0F0F0F0F0F0F;
+    spread = (spread | spread << 2) & 0x3333333333333333;
+    spread = (spread | spread << 1) & z_even_bits;
+    return spread;
+}
+
+inline uint32_t compact_bits(uint64_t spread)
+{
+    spread &= z_even_bits;
+    spread = (spread | spread >> 1) & 0x3333333333333333;
+    spread = (spread | spread >> 2) & 0x0F0F0F0F0F0F0F0F;
+    spread = (spread | spread >> 4) & 0x00FF00FF00FF00FF;
+    spread = (spread | spread >> 8) & 0x0000FFFF0000FFFF;
+    spread = (spread | spread >> 16) & 0x00000000FFFFFFFF;
+    return static_cast<uint32_t>(spread);
+}
+
+inline uint64_t z_order_encode(uint32_t x, uint32_t y)
+{
+    return spread_bits(x) | spread_bits(y) << 1;
+}
+
+inline uint32_t z_order_x(uint64_t z_value)
+{
+    return compact_bits(z_value);
+}
+
+inline uint32_t z_order_y(uint64_t z_value)
+{
+    return compact_bits(z_value >> 1);
+}
+
+inline bool z_order_in_box(uint64_t z_value, uint64_t z_min, uint64_t z_max)
+{
+    uint32_t x = z_order_x(z_value);
+    uint32_t y = z_order_y(z_value);
+    return x >= z_order_x(z_min) && x <= z_order_x(z_max) &&
+        y >= z_order_y(z_min) && y <= z_order_y(z_max);
+}
+
+// Returns the smallest key greater than z_value that lies inside the box spanned by
+// z_min and z_max (the BIGMIN of Tropf and Herzog). z_value must be outside the box
+// and between z_min and z_max.
+inline uint64_t z_order_next_in_box(uint64_t z_value, uint64_t z_min, uint64_t z_max)
+{
+    uint64_t next = 0;
+    for(int bit = 63; bit >= 0; bit--)
+    {
+        uint64_t bit_mask = (uint64_t)1 << bit;
+        // Lower bits belonging to the same dimension as this bit
+        uint64_t lower_dimension_bits = (bit % 2 == 0 ? z_even_bits : z_odd_bits) & (bit_mask - 1);
+        bool value_bit = z_value & bit_mask;
+        bool min_bit = z_min & bit_mask;
+        bool max_bit = z_max & bit_mask;
+
+        if(!value_bit && !min_bit && max_bit)
+        {
+            // Candidate in the upper half, keep searching in the lower half
+            next = (z_min & ~lower_dimension_bits) | bit_mask;
+            z_max = (z_max & ~bit_mask) | lower_dimension_bits;
+        }
+        else if(!value_bit && min_bit && max_bit)
+        {
+            return z_min;
+        }
+        else if(value_bit && !min_bit && !max_bit)
+        {
+            return next;
+        }
+        else if(value_bit && !min_bit && max_bit)
+        {
+            z_min = (z_min & ~lower_dimension_bits) | bit_mask;
+        }
+    }
+    return next;
+}
@@ -0,0 +1,172 @@
+#include "infiniverse.hpp"
+#include "change_mirror.hpp"
+#include "snapshot_rows.hpp"
+
+#include "test_helpers.hpp"
+
+#include <cstdio>
+
+const name self = "infiniverse"_n;
+const name alice = "alice"_n;
+const name bob = "bob"_n;
+const symbol inf = symbol("INF", 4);
+const compact_transform centered{32768, 32768, 0, 0, 0, 0, 0, 0};
+const uint32_t one_year = 60 * 60 * 24 * 365;
+// The chain's default max_inline_action_size
+const size_t max_inline_action_size = 4096;
+const char* snapshot_path = "change_mirror_tests.snapshot";
+
+size_t changes_actions = 0;
+size_t largest_changes_action = 0;
+
+// Runs the action, then feeds the changes actions it sent to the mirror as an indexer would
+template<typename F>
+void run(change_mirror::mirror& mirror, F&& action)
+{
+    eosio::host::sent_actions.clear();
+    {
+        infiniverse contract(self, self, eosio::datastream<const char*>(nullptr, 0));
+        action(contract);
+    }
+    for(const auto& sent_action : eosio::host::sent_actions)
+    {
+        if(sent_action.account != self || sent_action.action != "changes"_n)
+            continue;
+        changes_actions++;
+        largest_changes_action = std::max(largest_changes_action, sent_action.packed_data.size());
+        mirror.apply_action_data(sent_action.packed_data);
+    }
+}
+
+asset inf_amount(int64_t whole_inf)
+{
+    return asset(whole_inf * 10000, inf);
+}
+
+template<typename Row>
+bool rows_match(const std::map<uint64_t, eosio::host::stored_row>& stored, const std::map<uint64_t, Row>& mirrored)
+{
+    if(stored.size() != mirrored.size())
+        return false;
+    for(const auto& [id, row] : mirrored)
+    {
+        auto stored_itr = stored.find(id);
+        if(stored_itr == stored.end() || stored_itr->second.data != eosio::pack(row))
+            return false;
+    }
+    return true;
+}
+
+// Every land, persistent and poly row in the harness has the same packed bytes in the mirror
+bool mirror_matches_tables(const change_mirror::mirror& mirror)
+{
+    const std::map<uint64_t, eosio::host::stored_row> no_rows;
+    auto rows_of = [&](uint64_t scope, name table) -> const std::map<uint64_t, eosio::host::stored_row>& {
+        auto table_itr = eosio::host::tables().find({self.value, scope, table.value});
+        return table_itr == eosio::host::tables().end() ? no_rows : table_itr->second.rows;
+    };
+
+    bool matches = rows_match(rows_of(self.value, "land"_n), mirror.lands)
+        && rows_match(rows_of(self.value, "poly"_n), mirror.polys);
+    size_t persistent_scopes = 0;
+    for(const auto& [key, table] : eosio::host::tables())
+    {
+        const auto& [code, scope, table_name] = key;
+        if(code != self.value || table_name != "persistent"_n.value || table.rows.empty())
+            continue;
+        persistent_scopes++;
+        auto scope_itr = mirror.persistents.find(scope);
+        matches = matches && scope_itr != mirror.persistents.end() && rows_match(table.rows, scope_itr->second);
+    }
+    return matches && persistent_scopes == mirror.persistents.size();
+}
+
+void test_mirror_follows_actions()
+{
+    eosio::host::reset();
+    eosio::host::now_seconds = 1500000000;
+    eosio::host::authorizations = {self, alice, bob};
+    change_mirror::mirror mirror;
+    for(name owner : {alice, bob})
+    {
+        run(mirror, [&](infiniverse& c) { c.opendeposit(owner); });
+        run(mirror, [&](infiniverse& c) { c.depositinf(owner, self, inf_amount(1000000), ""); });
+    }
+
+    run(mirror, [&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+    run(mirror, [&](infiniverse& c) {
+        c.registerlands(bob, {{10.0005, 20.0015, 10, 20.001}, {10.0005, 20.0025, 10, 20.002}});
+    });
+    CHECK(mirror.lands.size() == 3);
+    CHECK(mirror_matches_tables(mirror));
+
+    // Enough placements that the records no longer fit in one inline action
+    changes_actions = 0;
+    std::vector<infiniverse::placement> placements;
+    for(int i = 0; i < 120; i++)
+    {
+        placements.push_back({std::string(10, 'a') + char('a' + i % 20), centered});
+    }
+    run(mirror, [&](infiniverse& c) { c.persistpolys(0, placements); });
+    CHECK(changes_actions > 1);
+    // The records of each action stay under the contract's 3 KB cap, plus the length of the vector
+    CHECK(largest_changes_action <= 3 * 1024 + 2);
+    CHECK(largest_changes_action <= max_inline_action_size);
+    CHECK(mirror.persistents[0].size() == 120);
+    CHECK(mirror.polys.size() == 20);
+    CHECK(mirror_matches_tables(mirror));
+
+    run(mirror, [&](infiniverse& c) { c.persistpoly(1, "bbbbbbbbbbb", centered); });
+    compact_transform moved{100, 200, 300, 400, 500, 600, 700, 800};
+    run(mirror, [&](infiniverse& c) { c.updatepersis(0, 5, 0, moved); });
+    run(mirror, [&](infiniverse& c) { c.updatepersis(0, 6, 1, centered); });
+    run(mirror, [&](infiniverse& c) { c.deletepersis(0, 7); });
+    run(mirror, [&](infiniverse& c) { c.deletepersis(1, 120); });
+    run(mirror, [&](infiniverse& c) { c.renewlands(bob, {1, 2}, 2); });
+    CHECK(mirror.lands[1].reg_end_date.utc_seconds == 1500000000 + 3 * one_year);
+    CHECK(mirror_matches_tables(mirror));
+
+    // An indexer can also start from a snapshot and follow the changes sent after it
+    land_snapshot::write_snapshot(snapshot_path, land_snapshot::export_host_tables(self));
+    land_snapshot::snapshot_view snapshot(snapshot_path);
+    change_mirror::mirror late_mirror;
+    late_mirror.load(snapshot);
+    CHECK(mirror_matches_tables(late_mirror));
+    run(late_mirror, [&](infiniverse& c) { c.deletepersis(0, 8); });
+    CHECK(mirror_matches_tables(late_mirror));
+    mirror = late_mirror;
+
+    // Reaping alice's land erases its persistents and releases their polys over several actions
+    eosio::host::now_seconds += one_year + 1;
+    for(int i = 0; i < 30 && mirror.lands.count(0); i++)
+    {
+        run(mirror, [&](infiniverse& c) { c.reaplands(50); });
+        CHECK(mirror_matches_tables(mirror));
+    }
+    CHECK(mirror.lands.size() == 2);
+    CHECK(mirror.persistents.count(0) == 0);
+    CHECK(mirror_matches_tables(mirror));
+}
+
+void test_rejects_invalid_records()
+{
+    change_mirror::mirror mirror;
+    CHECK_THROWS(mirror.apply({2, "land"_n, self.value, 0, {}}));
+    CHECK_THROWS(mirror.apply({0, "deposit"_n, self.value, 0, {}}));
+    // The packed row must be the row the record names
+    infiniverse_rows::land land{4, alice, 500, 500, 0, 0, eosio::time_point_sec(0)};
+    CHECK_THROWS(mirror.apply({0, "land"_n, self.value, 5, eosio::pack(land)}));
+    mirror.apply({0, "land"_n, self.value, 4, eosio::pack(land)});
+    CHECK(mirror.lands.size() == 1);
+    mirror.apply({1, "land"_n, self.value, 4, {}});
+    CHECK(mirror.lands.empty());
+    CHECK_THROWS(mirror.apply_action_data({char(5), char(0)}));
+}
+
+int main()
+{
+    test_mirror_follows_actions();
+    test_rejects_invalid_records();
+    std::remove(snapshot_path);
+    return report_tests("change_mirror_tests");
+}
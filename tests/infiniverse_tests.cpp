@@ -0,0 +1,609 @@
+#include "infiniverse.hpp"
+
+#include "test_helpers.hpp"
+
+using eosio::host::row_count;
+
+const name self = "infiniverse"_n;
+const name alice = "alice"_n;
+const name bob = "bob"_n;
+const symbol inf = symbol("INF", 4);
+const compact_transform centered{32768, 32768, 0, 0, 0, 0, 0, 0};
+const uint32_t one_year = 60 * 60 * 24 * 365;
+
+// Every action runs on a fresh contract object, as it does on chain
+template<typename F>
+void run(F&& action)
+{
+    infiniverse contract(self, self, eosio::datastream<const char*>(nullptr, 0));
+    action(contract);
+}
+
+asset inf_amount(int64_t whole_inf)
+{
+    return asset(whole_inf * 10000, inf);
+}
+
+void reset_chain()
+{
+    eosio::host::reset();
+    eosio::host::now_seconds = 1500000000;
+    eosio::host::authorizations = {self, alice, bob};
+}
+
+void open_deposit(name owner, int64_t whole_inf)
+{
+    run([&](infiniverse& c) { c.opendeposit(owner); });
+    run([&](infiniverse& c) { c.depositinf(owner, self, inf_amount(whole_inf), ""); });
+}
+
+size_t sent(name action)
+{
+    size_t count = 0;
+    for(const auto& sent_action : eosio::host::sent_actions)
+    {
+        if(sent_action.action == action)
+            count++;
+    }
+    return count;
+}
+
+// Quantity of the last inline INF transfer
+asset last_transfer()
+{
+    for(auto sent_itr = eosio::host::sent_actions.rbegin(); sent_itr != eosio::host::sent_actions.rend(); sent_itr++)
+    {
+        if(sent_itr->action == "transfer"_n)
+            return std::get<2>(std::any_cast<std::tuple<name, name, asset, std::string>>(sent_itr->data));
+    }
+    return asset(0, inf);
+}
+
+size_t polys()
+{
+    return row_count(self, self.value, "poly"_n);
+}
+
+size_t lands()
+{
+    return row_count(self, self.value, "land"_n);
+}
+
+size_t persistents(uint64_t land_id)
+{
+    return row_count(self, land_id, "persistent"_n);
+}
+
+struct deposit_row
+{
+    name owner;
+    asset balance;
+
+    uint64_t primary_key() const { return owner.value; }
+};
+
+struct land_row
+{
+    uint64_t id;
+    name owner;
+    int32_t lat_north_edge;
+    int32_t long_east_edge;
+    int32_t lat_south_edge;
+    int32_t long_west_edge;
+    eosio::time_point_sec reg_end_date;
+
+    uint64_t primary_key() const { return id; }
+};
+
+uint32_t reg_end_date(uint64_t land_id)
+{
+    eosio::multi_index<"land"_n, land_row> land_rows(self, self.value);
+    return land_rows.get(land_id).reg_end_date.utc_seconds;
+}
+
+struct fee_accrual_row
+{
+    asset accrued;
+    uint32_t unsettled_charges;
+    asset ram_reserve;
+};
+
+asset deposit_balance(name owner)
+{
+    eosio::multi_index<"deposit"_n, deposit_row> deposits(self, self.value);
+    return deposits.get(owner.value).balance;
+}
+
+uint32_t unsettled_charges()
+{
+    eosio::singleton<"feeaccrual"_n, fee_accrual_row> accrual(self, self.value);
+    return accrual.get().unsettled_charges;
+}
+
+struct persistent_row
+{
+    uint64_t id;
+    uint64_t land_id;
+    uint128_t source_and_asset_id;
+    compact_transform transform;
+
+    uint64_t primary_key() const { return id; }
+};
+
+typedef eosio::multi_index<"persistent"_n, persistent_row> persistent_rows;
+
+struct vector3
+{
+    float x;
+    float y;
+    float z;
+};
+
+// Persistents as written before they were scoped by land
+struct legacy_persistent
+{
+    uint64_t id;
+    uint64_t land_id;
+    uint128_t source_and_asset_id;
+    vector3 position;
+    vector3 orientation;
+    vector3 scale;
+
+    uint64_t primary_key() const { return id; }
+    uint64_t get_land_id() const { return land_id; }
+    uint128_t get_source_and_asset_id() const { return source_and_asset_id; }
+};
+
+typedef eosio::multi_index<"persistent"_n, legacy_persistent,
+    eosio::indexed_by<"bylandid"_n, eosio::const_mem_fun<legacy_persistent, uint64_t, &legacy_persistent::get_land_id>>,
+    eosio::indexed_by<"byassetid"_n,
+        eosio::const_mem_fun<legacy_persistent, uint128_t, &legacy_persistent::get_source_and_asset_id>>>
+    legacy_persistent_table;
+
+// Polys as written before the byuserpoly index and reference counts
+struct legacy_poly
+{
+    uint64_t id;
+    name user;
+    std::string poly_id;
+
+    uint64_t primary_key() const { return id; }
+    uint64_t get_user() const { return user.value; }
+};
+
+typedef eosio::multi_index<"poly"_n, legacy_poly,
+    eosio::indexed_by<"byuser"_n, eosio::const_mem_fun<legacy_poly, uint64_t, &legacy_poly::get_user>>>
+    legacy_poly_table;
+
+size_t legacy_persistents()
+{
+    return row_count(self, self.value, "persistent"_n);
+}
+
+// Land rows as written before edges were stored in micro degrees
+struct legacy_land
+{
+    uint64_t id;
+    name owner;
+    double lat_north_edge;
+    double long_east_edge;
+    double lat_south_edge;
+    double long_west_edge;
+    eosio::time_point_sec reg_end_date;
+
+    uint64_t primary_key() const { return id; }
+    uint64_t get_name() const { return owner.value; }
+    double get_lat_north_edge() const { return lat_north_edge; }
+    double get_long_east_edge() const { return long_east_edge; }
+    double get_lat_south_edge() const { return lat_south_edge; }
+    double get_long_west_edge() const { return long_west_edge; }
+};
+
+typedef eosio::multi_index<"land"_n, legacy_land,
+    eosio::indexed_by<"byowner"_n, eosio::const_mem_fun<legacy_land, uint64_t, &legacy_land::get_name>>,
+    eosio::indexed_by<"bylatnorth"_n, eosio::const_mem_fun<legacy_land, double, &legacy_land::get_lat_north_edge>>,
+    eosio::indexed_by<"bylongeast"_n, eosio::const_mem_fun<legacy_land, double, &legacy_land::get_long_east_edge>>,
+    eosio::indexed_by<"bylatsouth"_n, eosio::const_mem_fun<legacy_land, double, &legacy_land::get_lat_south_edge>>,
+    eosio::indexed_by<"bylongwest"_n, eosio::const_mem_fun<legacy_land, double, &legacy_land::get_long_west_edge>>>
+    legacy_land_table;
+
+void test_memo_registration()
+{
+    reset_chain();
+    run([&](infiniverse& c) { c.depositinf(alice, self, inf_amount(40000), "register:10.0005,20.0005,10,20"); });
+    CHECK(lands() == 1);
+    // Without an open deposit the change goes straight back to the sender
+    CHECK(sent("transfer"_n) == 1);
+    asset fee_and_ram = inf_amount(40000) - last_transfer();
+
+    auto register_by_memo = [&](const char* memo) {
+        run([&](infiniverse& c) { c.depositinf(bob, self, inf_amount(40000), memo); });
+    };
+    CHECK_ASSERT(register_by_memo("register:10.0005,20.0005,10"), "Memo must contain four comma separated edges");
+    CHECK_ASSERT(register_by_memo("register:1.0005,2.0005,1,2.0000001"), "Memo edges have at most six decimals");
+    CHECK_ASSERT(register_by_memo("register:1.0005,2.0005,1,2x"), "Memo has trailing characters");
+    CHECK_ASSERT(register_by_memo("register:1.0005,2.0005,1,"), "Memo edge is not a number");
+    CHECK_ASSERT(register_by_memo("register:1000,2.0005,1,2"), "Memo edge is out of range");
+    CHECK_ASSERT(register_by_memo("register:1,2.0005,1.0005,2"), "North edge must have greater latitude than south edge");
+    CHECK_ASSERT(register_by_memo("register:10.0003,20.0003,10.0001,20.0001"), "Intersecting land has already been registered");
+    CHECK_ASSERT(run([&](infiniverse& c) { c.depositinf(bob, self, inf_amount(1), "register:1.0005,2.0005,1,2"); }),
+        "Transfer does not cover the registration fee and the land's RAM");
+    // The same sized land costs the fee plus the RAM surcharge, one unit less is rejected
+    CHECK_ASSERT(run([&](infiniverse& c) {
+        c.depositinf(bob, self, fee_and_ram - asset(1, inf), "register:10.0005,40.0005,10,40");
+    }), "Transfer does not cover the registration fee and the land's RAM");
+    eosio::host::sent_actions.clear();
+    run([&](infiniverse& c) { c.depositinf(bob, self, fee_and_ram, "register:10.0005,30.0005,10,30"); });
+    CHECK(sent("transfer"_n) == 0);
+    CHECK(lands() == 2);
+
+    // Negative edges parse exactly, south and west of the equator and meridian
+    register_by_memo("register:-1.5,-2,-1.5001,-2.0001");
+    CHECK(lands() == 3);
+}
+
+void test_withdrawram()
+{
+    reset_chain();
+    run([&](infiniverse& c) { c.depositinf(alice, self, inf_amount(40000), "register:10.0005,20.0005,10,20"); });
+    run([&](infiniverse& c) { c.depositinf(bob, self, inf_amount(40000), "register:10.0005,30.0005,10,30"); });
+
+    // The reserve holds the RAM surcharge of both memo registrations
+    asset surcharge = asset(10000, inf);
+    CHECK_ASSERT(run([&](infiniverse& c) { c.withdrawram(alice, surcharge * 2 + asset(1, inf)); }),
+        "Withdrawal exceeds the RAM reserve");
+    CHECK_ASSERT(run([&](infiniverse& c) { c.withdrawram(alice, asset(0, inf)); }), "The amount must be positive");
+    run([&](infiniverse& c) { c.withdrawram(alice, surcharge); });
+    CHECK(last_transfer() == surcharge);
+    run([&](infiniverse& c) { c.withdrawram(alice, surcharge); });
+    CHECK_ASSERT(run([&](infiniverse& c) { c.withdrawram(alice, asset(1, inf)); }), "Withdrawal exceeds the RAM reserve");
+
+    eosio::host::authorizations = {alice};
+    CHECK_ASSERT(run([&](infiniverse& c) { c.withdrawram(alice, surcharge); }), "missing authority of infiniverse");
+}
+
+void test_transfermany_deposit()
+{
+    reset_chain();
+    run([&](infiniverse& c) { c.opendeposit(alice); });
+    // Only the entries paying us are credited, the others belong to their own recipients
+    run([&](infiniverse& c) {
+        c.depositmany(alice, {{bob, inf_amount(5)}, {self, inf_amount(7)}, {self, inf_amount(1)}}, "");
+    });
+    run([&](infiniverse& c) { c.closedeposit(alice); });
+    CHECK(last_transfer() == inf_amount(8));
+
+    CHECK_ASSERT(run([&](infiniverse& c) { c.depositmany(bob, {{self, inf_amount(1)}}, ""); }),
+        "User does not have a deposit opened");
+}
+
+void test_importlands()
+{
+    reset_chain();
+    CHECK_ASSERT(run([&](infiniverse& c) { c.importlands({}); }), "No lands to import");
+    CHECK_ASSERT(run([&](infiniverse& c) { c.importlands({{alice, 10002000, 20000500, 10000000, 20000000}}); }),
+        "Land cannot exceed a length of 100 meters on either side");
+    run([&](infiniverse& c) { c.importlands({{alice, 10000500, 20000500, 10000000, 20000000}}); });
+    CHECK(lands() == 1);
+
+    // Lands of a batch may lie anywhere, but must not overlap each other
+    CHECK_ASSERT(run([&](infiniverse& c) {
+        c.importlands({{alice, 30000500, 40000500, 30000000, 40000000}, {bob, -5000000, 500, -5000500, 0},
+            {bob, 30000700, 40000300, 30000200, 40000100}});
+    }), "Lands in the batch intersect each other");
+    CHECK(lands() == 1);
+    run([&](infiniverse& c) {
+        c.importlands({{alice, 30000500, 40000500, 30000000, 40000000}, {bob, -5000000, 500, -5000500, 0}});
+    });
+    CHECK(lands() == 3);
+}
+
+void test_migratelands()
+{
+    reset_chain();
+    {
+        legacy_land_table legacy_lands(self, self.value);
+        for(uint64_t id = 0; id < 3; id++)
+        {
+            legacy_lands.emplace(alice, [&](legacy_land& row) {
+                row = legacy_land{id, alice, 10.0005 + id, 20.0005, 10.0 + id, 20.0,
+                    eosio::time_point_sec(now() + one_year)};
+            });
+        }
+    }
+    CHECK(eosio::host::ram_of(alice) > 0);
+    open_deposit(alice, 1000000);
+
+    auto register_land = [&]() { run([&](infiniverse& c) { c.registerland(alice, 11.0005, 20.0015, 11, 20.001); }); };
+    CHECK_ASSERT(register_land(), "Lands must be migrated with migratelands first");
+    CHECK_ASSERT(run([&](infiniverse& c) { c.migratelands(0); }), "Must allow at least one land to be migrated");
+    run([&](infiniverse& c) { c.migratelands(2); });
+    CHECK_ASSERT(run([&](infiniverse& c) { c.renewlands(alice, {0}, 1); }), "Lands must be migrated with migratelands first");
+    run([&](infiniverse& c) { c.migratelands(2); });
+    CHECK_ASSERT(run([&](infiniverse& c) { c.migratelands(1); }), "Lands have already been migrated");
+
+    // The contract now pays for the lands, alice only pays for her deposit row
+    CHECK(lands() == 3);
+    CHECK(eosio::host::ram_of(alice) == eosio::host::row_overhead_bytes + 24);
+    // Every land keeps its id and edges
+    run([&](infiniverse& c) { c.renewlands(alice, {0, 1, 2}, 1); });
+    CHECK_ASSERT(run([&](infiniverse& c) { c.registerland(alice, 11.0003, 20.0003, 11.0001, 20.0001); }),
+        "Intersecting land has already been registered");
+    register_land();
+    CHECK(lands() == 4);
+}
+
+void test_registerlands()
+{
+    reset_chain();
+    open_deposit(alice, 1000000);
+    open_deposit(bob, 1000000);
+    // Lands of the same size in the same latitude band cost the same
+    run([&](infiniverse& c) { c.registerland(bob, 10.0005, 30.0005, 10, 30); });
+    asset land_fee = inf_amount(1000000) - deposit_balance(bob);
+    uint32_t charges = unsettled_charges();
+
+    auto register_lands = [&](std::vector<infiniverse::land_rect> rects) {
+        run([&](infiniverse& c) { c.registerlands(alice, rects); });
+    };
+    CHECK_ASSERT(register_lands({{10.0005, 21.0005, 10, 21}, {10.0004, 21.0006, 10.0001, 21.0001}}),
+        "Lands in the batch intersect each other");
+    CHECK_ASSERT(register_lands({{10.0005, 30.0015, 10, 30.001}, {10.0003, 30.0003, 10.0001, 30.0001}}),
+        "Intersecting land has already been registered");
+    CHECK_ASSERT(register_lands({{10.0005, 23.0005, 10, 23}, {10.0005, 23.0105, 10, 23.01}}),
+        "Lands in a batch must lie within 1000 meters of each other");
+    CHECK(lands() == 1);
+    CHECK(deposit_balance(alice) == inf_amount(1000000));
+
+    // The whole batch is paid with one deposit charge
+    register_lands({{10.0005, 20.0005, 10, 20}, {10.0005, 20.0015, 10, 20.001}, {10.0005, 20.0025, 10, 20.002}});
+    CHECK(lands() == 4);
+    CHECK(inf_amount(1000000) - deposit_balance(alice) == land_fee * 3);
+    CHECK(unsettled_charges() == charges + 1);
+}
+
+void test_updatepersis_moves_scope()
+{
+    reset_chain();
+    open_deposit(alice, 1000000);
+    open_deposit(bob, 1000000);
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0015, 10, 20.001); });
+    run([&](infiniverse& c) { c.registerland(bob, 10.0005, 20.0025, 10, 20.002); });
+    run([&](infiniverse& c) { c.persistpolys(0, {{"aaaaaaaaaaa", centered}, {"bbbbbbbbbbb", centered}}); });
+
+    compact_transform moved_transform{100, 200, 300, 400, 500, 600, 700, 800};
+    run([&](infiniverse& c) { c.updatepersis(0, 1, 1, moved_transform); });
+    CHECK(persistents(0) == 1);
+    CHECK(persistents(1) == 1);
+    persistent_rows old_scope(self, 0);
+    CHECK(old_scope.find(1) == old_scope.end());
+    persistent_rows new_scope(self, 1);
+    auto moved = new_scope.find(1);
+    CHECK(moved != new_scope.end());
+    CHECK(moved->land_id == 1);
+    CHECK(moved->transform.position_x == 100 && moved->transform.scale_z == 800);
+
+    // The object can't move onto a land of another owner
+    eosio::host::authorizations = {self, alice};
+    CHECK_ASSERT(run([&](infiniverse& c) { c.updatepersis(1, 1, 2, centered); }), "missing authority of bob");
+}
+
+void test_migratepers()
+{
+    reset_chain();
+    open_deposit(alice, 1000000);
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+    {
+        legacy_poly_table legacy_polys(self, self.value);
+        legacy_polys.emplace(alice, [&](legacy_poly& row) { row = legacy_poly{0, alice, "aaaaaaaaaaa"}; });
+        legacy_polys.emplace(alice, [&](legacy_poly& row) { row = legacy_poly{1, alice, "bbbbbbbbbbb"}; });
+        legacy_persistent_table legacy(self, self.value);
+        vector3 position{0.25f, 0, 0.75f};
+        vector3 orientation{90, 0, 0};
+        vector3 scale{1, 1, 1};
+        uint128_t poly_source = (uint128_t)1 << 64;
+        // Three objects on land 0 and one on a land that no longer exists
+        uint64_t land_ids[4] = {0, 0, 0, 5};
+        uint64_t poly_ids[4] = {0, 0, 1, 1};
+        for(uint64_t id = 0; id < 4; id++)
+        {
+            legacy.emplace(alice, [&](legacy_persistent& row) {
+                row = legacy_persistent{id, land_ids[id], poly_source | poly_ids[id], position, orientation, scale};
+            });
+        }
+    }
+
+    // New objects get ids after the legacy ones. Deleting one does not erase a poly legacy objects still place
+    run([&](infiniverse& c) { c.persistpoly(0, "ccccccccccc", centered); });
+    persistent_rows land_persistents(self, 0);
+    CHECK(land_persistents.find(4) != land_persistents.end());
+    run([&](infiniverse& c) { c.deletepersis(0, 4); });
+    CHECK(polys() == 2);
+
+    CHECK_ASSERT(run([&](infiniverse& c) { c.migratepers(0, 0); }), "Must allow at least one row to be migrated");
+    eosio::host::authorizations = {self, bob};
+    CHECK_ASSERT(run([&](infiniverse& c) { c.migratepers(0, 1); }), "missing authority of alice");
+    eosio::host::authorizations = {self, alice, bob};
+    run([&](infiniverse& c) { c.migratepers(0, 2); });
+    CHECK(persistents(0) == 2);
+    run([&](infiniverse& c) { c.migratepers(0, 10); });
+    CHECK(persistents(0) == 3);
+    CHECK(legacy_persistents() == 1);
+    CHECK_ASSERT(run([&](infiniverse& c) { c.migratepers(0, 1); }), "There are no persistents left to migrate");
+
+    // Objects keep their ids and their transforms are encoded
+    persistent_rows migrated(self, 0);
+    auto migrated_itr = migrated.find(0);
+    CHECK(migrated_itr != migrated.end());
+    CHECK(migrated_itr->transform.position_x == 16384 && migrated_itr->transform.position_z == 49152);
+    CHECK(migrated_itr->transform.orientation_x == 16384 && migrated_itr->transform.scale_x == encode_scale(1));
+
+    // The contract drops objects of lands that are gone
+    eosio::host::authorizations = {self};
+    run([&](infiniverse& c) { c.migratepers(5, 10); });
+    CHECK(legacy_persistents() == 0);
+    CHECK(polys() == 2);
+
+    // The moved objects are counted, so the polys go with their last placement
+    eosio::host::authorizations = {self, alice};
+    run([&](infiniverse& c) { c.deletepersis(0, 0); });
+    run([&](infiniverse& c) { c.deletepersis(0, 2); });
+    CHECK(polys() == 1);
+    run([&](infiniverse& c) { c.deletepersis(0, 1); });
+    CHECK(polys() == 0);
+    // Alice is left paying for her land and deposit rows, every legacy row she paid for is refunded
+    int64_t land_ram = eosio::host::row_overhead_bytes + 36 + 3 * eosio::host::index_entry_bytes<uint64_t>();
+    CHECK(eosio::host::ram_of(alice) == land_ram + eosio::host::row_overhead_bytes + 24);
+}
+
+void test_renewlands()
+{
+    reset_chain();
+    open_deposit(alice, 1000000);
+    open_deposit(bob, 1000000);
+    // Lands of the same size in the same latitude band cost the same
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+    asset land_fee = inf_amount(1000000) - deposit_balance(alice);
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0015, 10, 20.001); });
+    run([&](infiniverse& c) { c.registerland(bob, 10.0005, 20.0025, 10, 20.002); });
+    uint32_t registered_until = reg_end_date(0);
+    CHECK(reg_end_date(1) == registered_until);
+
+    // Every land costs its area fee for each year, charged from the deposit once for the whole batch
+    asset balance = deposit_balance(alice);
+    uint32_t charges = unsettled_charges();
+    run([&](infiniverse& c) { c.renewlands(alice, {1, 0}, 3); });
+    CHECK(balance - deposit_balance(alice) == land_fee * 2 * 3);
+    CHECK(unsettled_charges() == charges + 1);
+    CHECK(reg_end_date(0) == registered_until + 3 * one_year);
+    CHECK(reg_end_date(1) == registered_until + 3 * one_year);
+
+    // Nothing is charged for a batch with a land of another owner, a missing land or a repeated id
+    balance = deposit_balance(alice);
+    CHECK_ASSERT(run([&](infiniverse& c) { c.renewlands(alice, {0, 2}, 1); }),
+        "Land Id does not exist or is not owned by the user");
+    CHECK_ASSERT(run([&](infiniverse& c) { c.renewlands(alice, {7}, 1); }),
+        "Land Id does not exist or is not owned by the user");
+    CHECK_ASSERT(run([&](infiniverse& c) { c.renewlands(alice, {0, 1, 0}, 1); }), "Land Ids must be unique");
+    CHECK_ASSERT(run([&](infiniverse& c) { c.renewlands(alice, {}, 1); }), "No lands to renew");
+    CHECK_ASSERT(run([&](infiniverse& c) { c.renewlands(alice, {0}, 0); }),
+        "Lands must be renewed for at least one year");
+    CHECK(deposit_balance(alice) == balance);
+
+    // A lapsed land that has not been reaped is renewed from now, not from its old end date
+    eosio::host::now_seconds = reg_end_date(2) + 1000;
+    balance = deposit_balance(bob);
+    run([&](infiniverse& c) { c.renewlands(bob, {2}, 2); });
+    CHECK(reg_end_date(2) == now() + 2 * one_year);
+    CHECK(balance - deposit_balance(bob) == land_fee * 2);
+}
+
+void test_renewal_limit()
+{
+    reset_chain();
+    open_deposit(alice, 1000000);
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+    run([&](infiniverse& c) { c.renewlands(alice, {0}, 9); });
+    CHECK_ASSERT(run([&](infiniverse& c) { c.renewlands(alice, {0}, 1); }),
+        "Lands cannot be registered more than 10 years ahead");
+}
+
+void test_poly_refcount()
+{
+    reset_chain();
+    open_deposit(alice, 1000000);
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+
+    run([&](infiniverse& c) {
+        c.persistpolys(0, {{"aaaaaaaaaaa", centered}, {"bbbbbbbbbbb", centered}, {"aaaaaaaaaaa", centered}});
+    });
+    run([&](infiniverse& c) { c.persistpoly(0, "aaaaaaaaaaa", centered); });
+    CHECK(polys() == 2);
+    CHECK(persistents(0) == 4);
+
+    // The shared poly survives until its last placement is deleted
+    run([&](infiniverse& c) { c.deletepersis(0, 0); });
+    run([&](infiniverse& c) { c.deletepersis(0, 2); });
+    CHECK(polys() == 2);
+    run([&](infiniverse& c) { c.deletepersis(0, 3); });
+    CHECK(polys() == 1);
+    run([&](infiniverse& c) { c.deletepersis(0, 1); });
+    CHECK(polys() == 0);
+    CHECK(persistents(0) == 0);
+}
+
+void test_expired_land_is_reclaimed()
+{
+    reset_chain();
+    open_deposit(alice, 1000000);
+    open_deposit(bob, 1000000);
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+    run([&](infiniverse& c) { c.persistpolys(0, {{"aaaaaaaaaaa", centered}, {"bbbbbbbbbbb", centered}}); });
+
+    auto register_overlapping = [&]() {
+        run([&](infiniverse& c) { c.registerland(bob, 10.0003, 20.0003, 10.0001, 20.0001); });
+    };
+    CHECK_ASSERT(register_overlapping(), "Intersecting land has already been registered");
+
+    eosio::host::now_seconds += one_year;
+    register_overlapping();
+    CHECK(lands() == 1);
+    CHECK(persistents(0) == 0);
+    CHECK(polys() == 0);
+}
+
+void test_reclaim_is_bounded()
+{
+    reset_chain();
+    open_deposit(alice, 1000000);
+    open_deposit(bob, 1000000);
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+    std::vector<infiniverse::placement> placements(60, {"aaaaaaaaaaa", centered});
+    run([&](infiniverse& c) { c.persistpolys(0, placements); });
+
+    eosio::host::now_seconds += one_year;
+    CHECK_ASSERT(run([&](infiniverse& c) { c.registerland(bob, 10.0003, 20.0003, 10.0001, 20.0001); }),
+        "Intersecting expired land has too many objects, reap it with reaplands first");
+}
+
+void test_reaplands()
+{
+    reset_chain();
+    open_deposit(alice, 1000000);
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0015, 10, 20.001); });
+    run([&](infiniverse& c) { c.persistpolys(0, {{"aaaaaaaaaaa", centered}, {"bbbbbbbbbbb", centered}}); });
+    CHECK_ASSERT(run([&](infiniverse& c) { c.reaplands(10); }), "There are no expired lands to reap");
+
+    eosio::host::now_seconds += one_year;
+    CHECK_ASSERT(run([&](infiniverse& c) { c.reaplands(1); }),
+        "Must allow at least two rows to be erased, a persistent and its asset");
+    // Each persistent and the poly it releases count against the budget, which is never exceeded
+    run([&](infiniverse& c) { c.reaplands(3); });
+    CHECK(persistents(0) == 1);
+    CHECK(polys() == 1);
+    CHECK(lands() == 2);
+    run([&](infiniverse& c) { c.reaplands(10); });
+    CHECK(lands() == 0);
+    CHECK(polys() == 0);
+}
+
+int main()
+{
+    test_memo_registration();
+    test_withdrawram();
+    test_transfermany_deposit();
+    test_importlands();
+    test_migratelands();
+    test_registerlands();
+    test_updatepersis_moves_scope();
+    test_migratepers();
+    test_renewlands();
+    test_renewal_limit();
+    test_poly_refcount();
+    test_expired_land_is_reclaimed();
+    test_reclaim_is_bounded();
+    test_reaplands();
+    return report_tests("infiniverse_tests");
+}
@@ -0,0 +1,128 @@
+#include "infiniverse.hpp"
+#include "land_import.hpp"
+
+#include "test_helpers.hpp"
+
+#include <cstdio>
+#include <sstream>
+
+using land_import::imported_land;
+
+const name self = "infiniverse"_n;
+const name alice = "alice"_n;
+const name bob = "bob"_n;
+const char* snapshot_path = "land_import_tests.snapshot";
+
+// Lands of 500 micro degrees on a row starting at 10 N, 20 E
+imported_land land_at(name owner, int column)
+{
+    int32_t west = 20000000 + column * 1000;
+    return {owner, 10000500, west + 500, 10000000, west};
+}
+
+void test_parse_lands()
+{
+    std::istringstream input("# owner north east south west\n"
+        "alice 10000500 20000500 10000000 20000000\n"
+        "\n"
+        "bob -1000 -2000 -1500 -2500\n");
+    std::vector<imported_land> lands = land_import::parse_lands(input);
+    CHECK(lands.size() == 2);
+    CHECK(lands[1].owner == bob && lands[1].lat_south_edge == -1500 && lands[1].long_west_edge == -2500);
+
+    std::istringstream missing_edge("alice 10000500 20000500 10000000\n");
+    CHECK_THROWS(land_import::parse_lands(missing_edge));
+    std::istringstream trailing("alice 10000500 20000500 10000000 20000000 1\n");
+    CHECK_THROWS(land_import::parse_lands(trailing));
+    std::istringstream not_a_number("alice 10000500 east 10000000 20000000\n");
+    CHECK_THROWS(land_import::parse_lands(not_a_number));
+}
+
+void test_checks_land_limits()
+{
+    CHECK(land_import::plan_import({land_at(alice, 0)}, nullptr, 10).size() == 1);
+    CHECK_THROWS(land_import::plan_import({{alice, 85000000, 500, 84999500, 0}}, nullptr, 10));
+    CHECK_THROWS(land_import::plan_import({{alice, 500, 180000500, 0, 180000000}}, nullptr, 10));
+    CHECK_THROWS(land_import::plan_import({{alice, 0, 500, 500, 0}}, nullptr, 10));
+    CHECK_THROWS(land_import::plan_import({{alice, 500, 0, 0, 500}}, nullptr, 10));
+    // About 111 meters north to south
+    CHECK_THROWS(land_import::plan_import({{alice, 1000, 500, 0, 0}}, nullptr, 10));
+    CHECK_THROWS(land_import::plan_import({land_at(alice, 0)}, nullptr, 0));
+}
+
+void test_rejects_overlaps()
+{
+    std::vector<imported_land> lands;
+    for(int column = 0; column < 50; column++)
+    {
+        lands.push_back(land_at(column % 2 ? alice : bob, column));
+    }
+    CHECK(land_import::plan_import(lands, nullptr, 100).size() == 1);
+
+    // Overlaps are found anywhere in the set, not only within a batch
+    std::vector<imported_land> overlapping = lands;
+    overlapping.push_back({alice, 10000600, 20000300, 10000100, 20000200});
+    CHECK_THROWS(land_import::plan_import(overlapping, nullptr, 10));
+
+    // Touching edges do not intersect
+    std::vector<imported_land> touching = lands;
+    touching.push_back({alice, 10001000, 20000500, 10000500, 20000000});
+    CHECK(land_import::plan_import(touching, nullptr, 10).size() == 6);
+
+    // Registered lands from a snapshot are swept with the set
+    land_snapshot::snapshot_tables tables;
+    tables.lands.push_back({7, alice.value, alice.value, 10000400, 20050400, 10000100, 20050100, 0, 0});
+    land_snapshot::write_snapshot(snapshot_path, tables);
+    land_snapshot::snapshot_view existing(snapshot_path);
+    CHECK(land_import::plan_import(lands, &existing, 100).size() == 1);
+    lands.push_back(land_at(bob, 50));
+    std::string message;
+    try
+    {
+        land_import::plan_import(lands, &existing, 100);
+    }
+    catch(const std::runtime_error& e)
+    {
+        message = e.what();
+    }
+    CHECK(message == "Lands intersect: land 51 and registered land 7" ||
+        message == "Lands intersect: registered land 7 and land 51");
+}
+
+void test_batches_import_through_the_contract()
+{
+    eosio::host::reset();
+    eosio::host::authorizations = {self};
+    std::vector<imported_land> lands;
+    for(int column = 0; column < 25; column++)
+    {
+        lands.push_back(land_at(column % 3 ? alice : bob, column));
+    }
+    auto batches = land_import::plan_import(lands, nullptr, 10);
+    CHECK(batches.size() == 3 && batches[2].size() == 5);
+    CHECK(land_import::batch_json({land_at(alice, 0)}) == "{\"imports\":[{\"owner\":\"alice\",\"lat_north_edge\":10000500,"
+        "\"long_east_edge\":20000500,\"lat_south_edge\":10000000,\"long_west_edge\":20000000}]}");
+
+    for(const auto& batch : batches)
+    {
+        std::vector<infiniverse::imported_land> imports;
+        for(const imported_land& land : batch)
+        {
+            imports.push_back({land.owner, land.lat_north_edge, land.long_east_edge, land.lat_south_edge,
+                land.long_west_edge});
+        }
+        infiniverse contract(self, self, eosio::datastream<const char*>(nullptr, 0));
+        contract.importlands(imports);
+    }
+    CHECK(eosio::host::row_count(self, self.value, "land"_n) == 25);
+}
+
+int main()
+{
+    test_parse_lands();
+    test_checks_land_limits();
+    test_rejects_overlaps();
+    test_batches_import_through_the_contract();
+    std::remove(snapshot_path);
+    return report_tests("land_import_tests");
+}
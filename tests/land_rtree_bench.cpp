@@ -0,0 +1,96 @@
+#include "land_rtree.hpp"
+#include "lat_long_functions.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using land_rtree::land_box;
+using land_rtree::land_entry;
+
+// Times viewport and point queries on an STR packed R-tree against a linear scan of the same lands,
+// which is what a client holding the land table does without an index
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void bench(size_t land_count, size_t query_count)
+{
+    // Square grid of lands in cells of 1000 micro degrees
+    std::mt19937 random(static_cast<unsigned>(land_count));
+    std::uniform_int_distribution<int32_t> offset(0, 199);
+    std::uniform_int_distribution<int32_t> length(1, 800);
+    size_t cells = 1;
+    while(cells * cells < land_count)
+    {
+        cells++;
+    }
+    std::vector<land_entry> lands;
+    for(size_t i = 0; i < land_count; i++)
+    {
+        int32_t south = static_cast<int32_t>(i / cells) * 1000 + offset(random);
+        int32_t west = static_cast<int32_t>(i % cells) * 1000 + offset(random);
+        lands.push_back({i, {south + length(random), west + length(random), south, west}});
+    }
+
+    // Viewports of about a kilometer
+    std::uniform_int_distribution<int32_t> corner(0, static_cast<int32_t>(cells) * 1000);
+    std::vector<land_box> viewports;
+    for(size_t i = 0; i < query_count; i++)
+    {
+        int32_t south = corner(random);
+        int32_t west = corner(random);
+        viewports.push_back({south + 9000, west + 9000, south, west});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    land_rtree::rtree tree;
+    tree.bulk_load(lands);
+    double load_seconds = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t tree_hits = 0;
+    for(const land_box& viewport : viewports)
+    {
+        tree_hits += tree.query(viewport).size();
+    }
+    double tree_seconds = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t scan_hits = 0;
+    for(const land_box& viewport : viewports)
+    {
+        for(const land_entry& land : lands)
+        {
+            if(lands_intersect(land.box, viewport))
+                scan_hits++;
+        }
+    }
+    double scan_seconds = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t points_found = 0;
+    for(const land_box& viewport : viewports)
+    {
+        if(tree.find_at(viewport.lat_south_edge, viewport.long_west_edge))
+            points_found++;
+    }
+    double point_seconds = seconds_since(start);
+
+    std::printf("%8zu lands: load %.1f ms, viewport %.2f us (%.1f lands), scan %.2f us, point %.2f us (%zu found)%s\n",
+        land_count, load_seconds * 1e3, tree_seconds * 1e6 / query_count, (double)tree_hits / query_count,
+        scan_seconds * 1e6 / query_count, point_seconds * 1e6 / query_count, points_found,
+        tree_hits == scan_hits ? "" : " MISMATCH");
+}
+
+int main(int argc, char** argv)
+{
+    size_t max_lands = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    for(size_t land_count = 10000; land_count <= max_lands; land_count *= 10)
+    {
+        bench(land_count, 1000);
+    }
+    return 0;
+}
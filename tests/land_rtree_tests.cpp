@@ -0,0 +1,237 @@
+#include "land_rtree.hpp"
+#include "viewport_query.hpp"
+#include "infiniverse_rows.hpp"
+
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <random>
+
+using land_rtree::land_box;
+using land_rtree::land_entry;
+
+const eosio::name self = "infiniverse"_n;
+
+// Lands of up to 800 micro degrees in cells of 1000 around the given corner, so none overlap
+std::vector<land_entry> grid_lands(int32_t lat_south, int32_t long_west, int cells, std::mt19937& random)
+{
+    std::uniform_int_distribution<int32_t> offset(0, 199);
+    std::uniform_int_distribution<int32_t> length(1, 800);
+    std::vector<land_entry> lands;
+    for(int row = 0; row < cells; row++)
+    {
+        for(int column = 0; column < cells; column++)
+        {
+            int32_t south = lat_south + row * 1000 + offset(random);
+            int32_t west = long_west + column * 1000 + offset(random);
+            lands.push_back({lands.size(), {south + length(random), west + length(random), south, west}});
+        }
+    }
+    return lands;
+}
+
+std::vector<uint64_t> scan(const std::vector<land_entry>& lands, const land_box& viewport)
+{
+    std::vector<uint64_t> ids;
+    for(const land_entry& land : lands)
+    {
+        if(lands_intersect(land.box, viewport))
+            ids.push_back(land.id);
+    }
+    return ids;
+}
+
+std::vector<uint64_t> sorted(std::vector<uint64_t> ids)
+{
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+land_box random_viewport(std::mt19937& random, int32_t lat_south, int32_t long_west, int32_t extent)
+{
+    std::uniform_int_distribution<int32_t> corner(-2000, extent);
+    std::uniform_int_distribution<int32_t> size(0, 5000);
+    int32_t south = lat_south + corner(random);
+    int32_t west = long_west + corner(random);
+    return {south + size(random), west + size(random), south, west};
+}
+
+void test_bulk_load_queries()
+{
+    std::mt19937 random(1);
+    std::vector<land_entry> lands = grid_lands(10000000, 20000000, 60, random);
+    land_rtree::rtree tree;
+    tree.bulk_load(lands);
+    CHECK(tree.size() == lands.size());
+    // 3600 lands in leaves of 16 need three levels
+    CHECK(tree.height() == 3);
+
+    for(int i = 0; i < 200; i++)
+    {
+        land_box viewport = random_viewport(random, 10000000, 20000000, 60000);
+        CHECK(sorted(tree.query(viewport)) == scan(lands, viewport));
+    }
+
+    // Touching edges do not intersect
+    const land_entry& first = lands.front();
+    land_box east_of_first{first.box.lat_north_edge, first.box.long_east_edge + 10, first.box.lat_south_edge,
+        first.box.long_east_edge};
+    CHECK(tree.query(east_of_first).empty());
+
+    // Points on the south and west edges belong to the land
+    CHECK(tree.find_at(first.box.lat_south_edge, first.box.long_west_edge)->id == first.id);
+    CHECK(tree.find_at(first.box.lat_north_edge - 1, first.box.long_east_edge - 1)->id == first.id);
+    CHECK(tree.find_at(first.box.lat_north_edge, first.box.long_west_edge) == nullptr);
+    CHECK(tree.find_at(0, 0) == nullptr);
+
+    land_rtree::rtree empty;
+    empty.bulk_load({});
+    CHECK(empty.size() == 0 && empty.query({90000000, 180000000, -90000000, -180000000}).empty());
+}
+
+void test_insert_and_erase()
+{
+    std::mt19937 random(2);
+    std::vector<land_entry> lands = grid_lands(-5000000, -60000000, 40, random);
+    std::shuffle(lands.begin(), lands.end(), random);
+
+    // Half bulk loaded, half inserted one by one
+    land_rtree::rtree tree;
+    tree.bulk_load(std::vector<land_entry>(lands.begin(), lands.begin() + lands.size() / 2));
+    for(size_t i = lands.size() / 2; i < lands.size(); i++)
+    {
+        tree.insert(lands[i]);
+    }
+    CHECK(tree.size() == lands.size());
+    std::vector<land_entry> live = lands;
+    std::sort(live.begin(), live.end(), [](const land_entry& a, const land_entry& b) { return a.id < b.id; });
+    for(int i = 0; i < 100; i++)
+    {
+        land_box viewport = random_viewport(random, -5000000, -60000000, 40000);
+        CHECK(sorted(tree.query(viewport)) == scan(live, viewport));
+    }
+
+    // Only an entry with the same id and box is erased
+    CHECK(!tree.erase(lands[0].id + 100000, lands[0].box));
+    CHECK(!tree.erase(lands[0].id, lands[1].box));
+
+    // Erasing most lands shrinks the tree and keeps the rest findable
+    for(size_t i = 0; i < lands.size() - 10; i++)
+    {
+        CHECK(tree.erase(lands[i].id, lands[i].box));
+    }
+    CHECK(!tree.erase(lands[0].id, lands[0].box));
+    CHECK(tree.size() == 10);
+    CHECK(tree.height() <= 2);
+    live.assign(lands.end() - 10, lands.end());
+    std::sort(live.begin(), live.end(), [](const land_entry& a, const land_entry& b) { return a.id < b.id; });
+    land_box everything{90000000, 180000000, -90000000, -180000000};
+    CHECK(sorted(tree.query(everything)) == scan(live, everything));
+    for(const land_entry& land : live)
+    {
+        CHECK(tree.find_at(land.box.lat_south_edge, land.box.long_west_edge)->id == land.id);
+    }
+    for(const land_entry& land : live)
+    {
+        CHECK(tree.erase(land.id, land.box));
+    }
+    CHECK(tree.size() == 0 && tree.height() == 1 && tree.query(everything).empty());
+}
+
+// Walks the byzorder index of the land table in the host harness, a page of rows per call
+struct harness_pages {
+    size_t page_rows;
+    size_t rows_read = 0;
+
+    std::vector<infiniverse_rows::land> operator()(uint64_t lower_bound)
+    {
+        infiniverse_rows::land_table lands(self, self.value);
+        auto z_order_index = lands.get_index<"byzorder"_n>();
+        std::vector<infiniverse_rows::land> page;
+        for(auto lands_itr = z_order_index.lower_bound(lower_bound);
+            lands_itr != z_order_index.end() && page.size() < page_rows; lands_itr++)
+        {
+            page.push_back(*lands_itr);
+        }
+        rows_read += page.size();
+        return page;
+    }
+};
+
+void load_harness(const std::vector<land_entry>& lands)
+{
+    eosio::host::reset();
+    infiniverse_rows::land_table table(self, self.value);
+    for(const land_entry& land : lands)
+    {
+        table.emplace(self, [&](infiniverse_rows::land& row) {
+            row = {land.id, "alice"_n, land.box.lat_north_edge, land.box.long_east_edge, land.box.lat_south_edge,
+                land.box.long_west_edge, eosio::time_point_sec(0)};
+        });
+    }
+}
+
+void test_viewport_query_helper()
+{
+    std::mt19937 random(3);
+    std::vector<land_entry> lands = grid_lands(10000000, 20000000, 40, random);
+    load_harness(lands);
+    // The tree loads straight from land rows
+    land_rtree::rtree tree;
+    tree.bulk_load(land_rtree::land_entries(infiniverse_rows::land_table(self, self.value)));
+    for(int i = 0; i < 100; i++)
+    {
+        land_box box = random_viewport(random, 10000000, 20000000, 40000);
+        viewport_query::viewport view{box.lat_north_edge, box.long_east_edge, box.lat_south_edge, box.long_west_edge};
+        harness_pages pages{20};
+        std::vector<uint64_t> ids;
+        for(const infiniverse_rows::land& land : viewport_query::lands_in_viewport(view, pages))
+        {
+            ids.push_back(land.id);
+        }
+        CHECK(sorted(ids) == scan(lands, box));
+        CHECK(sorted(tree.query(box)) == sorted(ids));
+    }
+}
+
+void test_viewport_query_skips_outside_keys()
+{
+    // A grid around 44.217728 N, 88.435456 E, where both coordinates cross a power of two in z-order space
+    std::mt19937 random(4);
+    std::vector<land_entry> lands = grid_lands(44217728 - 50000, 88435456 - 50000, 100, random);
+    load_harness(lands);
+
+    land_box box{44217728 + 1500, 88435456 + 1500, 44217728 - 1500, 88435456 - 1500};
+    viewport_query::viewport view{box.lat_north_edge, box.long_east_edge, box.lat_south_edge, box.long_west_edge};
+    viewport_query::corner_keys keys = viewport_query::viewport_corner_keys(view);
+    size_t rows_between_corners = 0;
+    for(const land_entry& land : lands)
+    {
+        uint64_t key = viewport_query::land_corner_key(land.box);
+        if(key >= keys.z_min && key <= keys.z_max)
+            rows_between_corners++;
+    }
+
+    harness_pages pages{20};
+    size_t pages_read = 0;
+    std::vector<uint64_t> ids;
+    for(const infiniverse_rows::land& land : viewport_query::lands_in_viewport(view, pages, &pages_read))
+    {
+        ids.push_back(land.id);
+    }
+    CHECK(!ids.empty());
+    CHECK(sorted(ids) == scan(lands, box));
+    // Paging through the keys between the corners would read thousands of rows
+    CHECK(rows_between_corners > 1000);
+    CHECK(pages.rows_read * 10 < rows_between_corners);
+    CHECK(pages_read < 20);
+}
+
+int main()
+{
+    test_bulk_load_queries();
+    test_insert_and_erase();
+    test_viewport_query_helper();
+    test_viewport_query_skips_outside_keys();
+    return report_tests("land_rtree_tests");
+}
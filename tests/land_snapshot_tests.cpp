@@ -0,0 +1,209 @@
+#include "infiniverse.hpp"
+#include "snapshot_rows.hpp"
+
+#include "test_helpers.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using eosio::host::row_count;
+
+const name self = "infiniverse"_n;
+const name alice = "alice"_n;
+const name bob = "bob"_n;
+const symbol inf = symbol("INF", 4);
+const compact_transform centered{32768, 32768, 0, 0, 0, 0, 0, 0};
+const char* snapshot_path = "land_snapshot_tests.snapshot";
+
+template<typename F>
+void run(F&& action)
+{
+    infiniverse contract(self, self, eosio::datastream<const char*>(nullptr, 0));
+    action(contract);
+}
+
+asset inf_amount(int64_t whole_inf)
+{
+    return asset(whole_inf * 10000, inf);
+}
+
+void reset_chain()
+{
+    eosio::host::reset();
+    eosio::host::now_seconds = 1500000000;
+    eosio::host::authorizations = {self, alice, bob};
+}
+
+// Alice owns lands 0 and 2 with three placements, bob owns land 1 with one
+void build_world()
+{
+    reset_chain();
+    for(name owner : {alice, bob})
+    {
+        run([&](infiniverse& c) { c.opendeposit(owner); });
+        run([&](infiniverse& c) { c.depositinf(owner, self, inf_amount(1000000), ""); });
+    }
+    run([&](infiniverse& c) { c.registerland(alice, 10.0005, 20.0005, 10, 20); });
+    run([&](infiniverse& c) { c.registerland(bob, 10.0005, 30.0005, 10, 30); });
+    run([&](infiniverse& c) { c.registerland(alice, -10, -20, -10.0005, -20.0005); });
+    run([&](infiniverse& c) {
+        c.persistpolys(0, {{"aaaaaaaaaaa", centered}, {"bbbbbbbbbbb", centered}, {"aaaaaaaaaaa", centered}});
+    });
+    run([&](infiniverse& c) { c.persistpoly(1, "ccccccccccc", centered); });
+}
+
+// Packed rows and payers of the tables a snapshot holds, keyed by scope and table
+std::map<std::pair<uint64_t, uint64_t>, std::map<uint64_t, std::pair<std::vector<char>, name>>> snapshot_tables_now()
+{
+    std::map<std::pair<uint64_t, uint64_t>, std::map<uint64_t, std::pair<std::vector<char>, name>>> result;
+    for(const auto& [key, table] : eosio::host::tables())
+    {
+        const auto& [code, scope, table_name] = key;
+        if(code != self.value || (table_name != "land"_n.value && table_name != "persistent"_n.value
+            && table_name != "poly"_n.value && table_name != "deposit"_n.value) || table.rows.empty())
+        {
+            continue;
+        }
+        for(const auto& [id, stored] : table.rows)
+        {
+            result[{scope, table_name}][id] = {stored.data, stored.payer};
+        }
+    }
+    return result;
+}
+
+std::vector<char> file_bytes(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void test_round_trip()
+{
+    build_world();
+    auto tables_before = snapshot_tables_now();
+    int64_t alice_ram = eosio::host::ram_of(alice);
+    int64_t bob_ram = eosio::host::ram_of(bob);
+
+    land_snapshot::write_snapshot(snapshot_path, land_snapshot::export_host_tables(self));
+    land_snapshot::snapshot_view snapshot(snapshot_path);
+    CHECK(snapshot.header().version == land_snapshot::snapshot_version);
+    CHECK(snapshot.header().next_persistent_id == 4);
+    CHECK(snapshot.lands().size() == 3);
+    CHECK(snapshot.persistents().size() == 4);
+    CHECK(snapshot.polys().size() == 3);
+    CHECK(snapshot.deposits().size() == 2);
+    CHECK(snapshot.find_land(1) && snapshot.find_land(1)->owner == bob.value);
+    CHECK(snapshot.find_land(3) == nullptr);
+    CHECK(snapshot.persistents_of(0).size() == 3);
+    CHECK(snapshot.persistents_of(1).size() == 1 && snapshot.persistents_of(1)[0].id == 3);
+    CHECK(snapshot.persistents_of(2).empty());
+
+    // The loaded tables hold the same packed rows, billed to the same payers
+    reset_chain();
+    land_snapshot::load_host_tables(self, snapshot);
+    CHECK(snapshot_tables_now() == tables_before);
+    CHECK(eosio::host::ram_of(alice) == alice_ram);
+    CHECK(eosio::host::ram_of(bob) == bob_ram);
+    CHECK(eosio::host::authorizations == std::vector<name>({self, alice, bob}));
+    CHECK_THROWS(land_snapshot::load_host_tables(self, snapshot));
+}
+
+void test_loaded_tables_serve_actions()
+{
+    build_world();
+    land_snapshot::write_snapshot(snapshot_path, land_snapshot::export_host_tables(self));
+    land_snapshot::snapshot_view snapshot(snapshot_path);
+    reset_chain();
+    land_snapshot::load_host_tables(self, snapshot);
+
+    // Ids continue after the snapshot and the secondary indexes are in place
+    run([&](infiniverse& c) { c.persistpoly(2, "aaaaaaaaaaa", centered); });
+    CHECK(row_count(self, 2, "persistent"_n) == 1);
+    CHECK(row_count(self, self.value, "poly"_n) == 3);
+    run([&](infiniverse& c) { c.deletepersis(0, 0); });
+    run([&](infiniverse& c) { c.deletepersis(0, 2); });
+    run([&](infiniverse& c) { c.deletepersis(2, 4); });
+    CHECK(row_count(self, self.value, "poly"_n) == 2);
+    CHECK_ASSERT(run([&](infiniverse& c) { c.registerland(bob, 10.0003, 20.0003, 10.0001, 20.0001); }),
+        "Intersecting land has already been registered");
+    run([&](infiniverse& c) { c.registerland(bob, 50.0005, 20.0005, 50, 20); });
+    CHECK(row_count(self, self.value, "land"_n) == 4);
+    run([&](infiniverse& c) { c.closedeposit(bob); });
+    CHECK(row_count(self, self.value, "deposit"_n) == 1);
+}
+
+void test_rows_text_round_trip()
+{
+    build_world();
+    land_snapshot::write_snapshot(snapshot_path, land_snapshot::export_host_tables(self));
+    std::vector<char> original = file_bytes(snapshot_path);
+    std::vector<std::string> rows;
+    {
+        land_snapshot::snapshot_view snapshot(snapshot_path);
+        rows = land_snapshot::dump_rows(snapshot);
+    }
+    CHECK(rows.size() == 1 + 3 + 4 + 3 + 2);
+    land_snapshot::write_snapshot(snapshot_path, land_snapshot::parse_rows(rows));
+    CHECK(file_bytes(snapshot_path) == original);
+
+    CHECK_THROWS(land_snapshot::parse_rows({"land 0 alice 0g"}));
+    CHECK_THROWS(land_snapshot::parse_rows({"table 0 alice 00"}));
+}
+
+void test_rejects_invalid_files()
+{
+    build_world();
+    land_snapshot::write_snapshot(snapshot_path, land_snapshot::export_host_tables(self));
+    std::vector<char> original = file_bytes(snapshot_path);
+
+    auto write_bytes = [](const std::vector<char>& bytes) {
+        std::ofstream file(snapshot_path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), bytes.size());
+    };
+
+    std::vector<char> bytes = original;
+    bytes[0] = 'X';
+    write_bytes(bytes);
+    CHECK_THROWS(land_snapshot::snapshot_view{snapshot_path});
+
+    bytes = original;
+    bytes[offsetof(land_snapshot::snapshot_header, version)] = 2;
+    write_bytes(bytes);
+    CHECK_THROWS(land_snapshot::snapshot_view{snapshot_path});
+
+    // A truncated file can't hold the records its header counts
+    bytes = original;
+    bytes.resize(bytes.size() - 1);
+    write_bytes(bytes);
+    CHECK_THROWS(land_snapshot::snapshot_view{snapshot_path});
+
+    bytes.resize(10);
+    write_bytes(bytes);
+    CHECK_THROWS(land_snapshot::snapshot_view{snapshot_path});
+    CHECK_THROWS(land_snapshot::snapshot_view{"missing.snapshot"});
+}
+
+void test_export_requires_migrated_tables()
+{
+    build_world();
+    infiniverse_rows::land_migration_singleton(self, self.value).set({0, false}, self);
+    CHECK_THROWS(land_snapshot::export_host_tables(self));
+
+    build_world();
+    infiniverse_rows::poly_table polys(self, self.value);
+    polys.modify(polys.get(0), self, [](infiniverse_rows::poly& row) { row.refcount.reset(); });
+    CHECK_THROWS(land_snapshot::export_host_tables(self));
+}
+
+int main()
+{
+    test_round_trip();
+    test_loaded_tables_serve_actions();
+    test_rows_text_round_trip();
+    test_rejects_invalid_files();
+    test_export_requires_migrated_tables();
+    std::remove(snapshot_path);
+    return report_tests("land_snapshot_tests");
+}
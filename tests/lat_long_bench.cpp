@@ -0,0 +1,61 @@
+#include "lat_long_functions.cpp"
+
+#include "lat_long_reference.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Compares the integer kernel with the double implementation it replaced on the same random lands.
+// Native timings only show the relative cost, under WASM soft float the double version is slower still.
+struct land_edges {
+    int32_t lat_north;
+    int32_t lat_south;
+    int32_t long_east;
+    int32_t long_west;
+};
+
+template<typename F>
+double nanoseconds_per_call(const std::vector<land_edges>& lands, F&& measure)
+{
+    volatile int64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int round = 0; round < 20; round++)
+    {
+        for(const land_edges& land : lands)
+        {
+            sink = sink + measure(land);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (20.0 * lands.size());
+}
+
+int main()
+{
+    std::mt19937 rng(7);
+    std::vector<land_edges> lands(1000000);
+    for(land_edges& land : lands)
+    {
+        land.lat_south = static_cast<int32_t>(rng() % 170000000) - 85000000;
+        land.long_west = static_cast<int32_t>(rng() % 359000000) - 179000000;
+        land.lat_north = land.lat_south + 1 + rng() % 900;
+        land.long_east = land.long_west + 1 + rng() % 900;
+    }
+
+    double integer_ns = nanoseconds_per_call(lands, [](const land_edges& land) {
+        std::pair<int64_t, int64_t> size = lat_long_to_millimeters(land.lat_north, land.lat_south,
+            land.long_east, land.long_west);
+        return size.first + size.second;
+    });
+    double double_ns = nanoseconds_per_call(lands, [](const land_edges& land) {
+        std::pair<double, double> size = reference_lat_long_to_meters(land.lat_north / 1e6, land.lat_south / 1e6,
+            land.long_east / 1e6, land.long_west / 1e6);
+        return static_cast<int64_t>((size.first + size.second) * 1000);
+    });
+
+    std::printf("lat_long_to_millimeters   %.2f ns/call\n", integer_ns);
+    std::printf("double lat_long_to_meters %.2f ns/call\n", double_ns);
+    return 0;
+}
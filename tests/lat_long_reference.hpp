@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cmath>
+#include <utility>
+
+// The double implementation that lat_long_to_millimeters replaced, kept as the reference it is measured against
+inline std::pair<double, double> reference_lat_long_to_meters(double lat1, double lat2, double long1, double long2)
+{
+    double average_lat_radians = (lat1 + lat2) / 2 * M_PI / 180;
+    double lat_distance_meters = std::abs(lat1 - lat2) * 111133;
+    double long_distance_meters = std::abs(long1 - long2) * 111320 * std::cos(average_lat_radians);
+    return std::pair<double, double>(lat_distance_meters, long_distance_meters);
+}
@@ -0,0 +1,87 @@
+#include "lat_long_functions.cpp"
+
+#include "lat_long_reference.hpp"
+#include "test_helpers.hpp"
+
+#include <random>
+
+const int32_t max_land_micro_degrees = 2000;
+const int64_t max_land_length_mm = 100000;
+
+// Random lands up to about 100 meters across the registrable latitudes, the same as the contract accepts
+void test_error_against_double_implementation()
+{
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int32_t> lat_dist(-85000000 + max_land_micro_degrees, 85000000 - max_land_micro_degrees);
+    std::uniform_int_distribution<int32_t> long_dist(-180000000 + max_land_micro_degrees, 180000000 - max_land_micro_degrees);
+    std::uniform_int_distribution<int32_t> size_dist(1, max_land_micro_degrees);
+
+    double worst_error_mm = 0;
+    for(int i = 0; i < 2000000; i++)
+    {
+        int32_t lat_south = lat_dist(rng);
+        int32_t long_west = long_dist(rng);
+        int32_t lat_north = lat_south + size_dist(rng) / 2;
+        int32_t long_east = long_west + size_dist(rng);
+
+        std::pair<double, double> expected = reference_lat_long_to_meters(lat_north / 1e6, lat_south / 1e6,
+            long_east / 1e6, long_west / 1e6);
+        if(expected.first > 100 || expected.second > 100)
+        {
+            continue;
+        }
+        std::pair<int64_t, int64_t> actual = lat_long_to_millimeters(lat_north, lat_south, long_east, long_west);
+        worst_error_mm = std::max(worst_error_mm, std::abs(actual.first - expected.first * 1000));
+        worst_error_mm = std::max(worst_error_mm, std::abs(actual.second - expected.second * 1000));
+    }
+    std::printf("worst difference from the double implementation %.2f mm\n", worst_error_mm);
+    CHECK(worst_error_mm < 3);
+}
+
+void test_fixed_cos_lat()
+{
+    CHECK(fixed_cos_lat(0) == cos_one);
+    CHECK(fixed_cos_lat(60000000) == cos_one / 2);
+    CHECK(fixed_cos_lat(-60000000) == cos_one / 2);
+    CHECK(fixed_cos_lat(90000000) == 0);
+    for(int64_t lat = 0; lat <= 90000000; lat += 12345)
+    {
+        double expected = std::cos(lat / 1e6 * M_PI / 180) * cos_one;
+        CHECK(std::abs(fixed_cos_lat(lat) - expected) < 4);
+    }
+}
+
+// Every land no longer than the maximum length must fit within the span used to bound overlap queries
+void test_long_span_covers_max_length()
+{
+    std::mt19937 rng(6);
+    std::uniform_int_distribution<int32_t> lat_dist(-85000000, 85000000 - max_land_micro_degrees);
+    for(int i = 0; i < 20000; i++)
+    {
+        int32_t lat_south = lat_dist(rng);
+        int32_t lat_north = lat_south + 1 + rng() % 900;
+        int32_t span = millimeters_to_long_span(max_land_length_mm, lat_north, lat_south);
+
+        // The widest land that still measures within the maximum length
+        int32_t low = 0;
+        int32_t high = 40000000;
+        while(low < high)
+        {
+            int32_t mid = low + (high - low + 1) / 2;
+            if(lat_long_to_millimeters(lat_north, lat_south, mid, 0).second <= max_land_length_mm)
+                low = mid;
+            else
+                high = mid - 1;
+        }
+        CHECK(low <= span);
+    }
+    CHECK(millimeters_to_lat_span(max_land_length_mm) * meters_per_degree_latitude >= max_land_length_mm * 1000);
+}
+
+int main()
+{
+    test_error_against_double_implementation();
+    test_fixed_cos_lat();
+    test_long_span_covers_max_length();
+    return report_tests("lat_long_tests");
+}
@@ -0,0 +1,157 @@
+#include "infiniverse.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+// Times registerland against land tables of 10k, 100k and 1M lands spread uniformly over the globe,
+// packed into a few dense clusters, or lined up along a narrow east west stripe.
+// The chain bills WASM instructions, which a native build cannot count, so the rows each registration
+// reads and the index seeks it makes are reported next to the native time, which only ranks the cases.
+const name self = "infiniverse"_n;
+const name alice = "alice"_n;
+const symbol inf = symbol("INF", 4);
+// Lands are half a 0.001 degree grid cell on each side, so lands in distinct cells never intersect
+const int32_t cell_micro_degrees = 1000;
+const int32_t land_micro_degrees = 500;
+const size_t measured_registrations = 1000;
+const size_t import_batch_size = 100;
+
+enum class land_layout { uniform, clustered, stripe };
+
+const char* layout_name(land_layout layout)
+{
+    switch(layout)
+    {
+        case land_layout::uniform: return "uniform";
+        case land_layout::clustered: return "clustered";
+        default: return "stripe";
+    }
+}
+
+struct cell {
+    int32_t row;
+    int32_t col;
+};
+
+struct bench_result {
+    double rows_read;
+    double index_seeks;
+    double microseconds;
+    double ram_bytes_per_land;
+};
+
+template<typename F>
+void run(F&& action)
+{
+    infiniverse contract(self, self, eosio::datastream<const char*>(nullptr, 0));
+    action(contract);
+    // Inline actions are recorded, not executed, drop them so they don't pile up
+    eosio::host::sent_actions.clear();
+}
+
+// Distinct cells, the first land_count are imported and the rest are registered while measuring
+std::vector<cell> generate_cells(land_layout layout, size_t count, std::mt19937_64& rng)
+{
+    std::uniform_int_distribution<int32_t> rows(-80000, 79999);
+    std::uniform_int_distribution<int32_t> cols(-179000, 178999);
+    std::normal_distribution<double> spread(0, 200);
+    std::vector<cell> centers(16);
+    for(cell& center : centers)
+    {
+        center = {rows(rng), cols(rng)};
+    }
+
+    std::unordered_set<uint64_t> used;
+    std::vector<cell> cells;
+    cells.reserve(count);
+    while(cells.size() < count)
+    {
+        cell next;
+        if(layout == land_layout::uniform)
+        {
+            next = {rows(rng), cols(rng)};
+        }
+        else if(layout == land_layout::clustered)
+        {
+            const cell& center = centers[rng() % centers.size()];
+            next = {center.row + static_cast<int32_t>(spread(rng)),
+                std::clamp(center.col + static_cast<int32_t>(spread(rng)), -179000, 178999)};
+        }
+        else
+        {
+            next = {10000 + static_cast<int32_t>(rng() % 4), cols(rng)};
+        }
+        if(used.insert((uint64_t)(uint32_t)next.row << 32 | (uint32_t)next.col).second)
+        {
+            cells.push_back(next);
+        }
+    }
+    return cells;
+}
+
+bench_result measure(land_layout layout, size_t land_count)
+{
+    eosio::host::reset();
+    eosio::host::now_seconds = 1500000000;
+    eosio::host::authorizations = {self, alice};
+    std::mt19937_64 rng(land_count * 3 + static_cast<size_t>(layout));
+    std::vector<cell> cells = generate_cells(layout, land_count + measured_registrations, rng);
+
+    std::vector<infiniverse::imported_land> batch;
+    for(size_t i = 0; i < land_count; i++)
+    {
+        int32_t south = cells[i].row * cell_micro_degrees;
+        int32_t west = cells[i].col * cell_micro_degrees;
+        batch.push_back({alice, south + land_micro_degrees, west + land_micro_degrees, south, west});
+        if(batch.size() == import_batch_size || i + 1 == land_count)
+        {
+            run([&](infiniverse& c) { c.importlands(batch); });
+            batch.clear();
+        }
+    }
+    int64_t table_ram = eosio::host::ram_of(self);
+
+    run([&](infiniverse& c) { c.opendeposit(alice); });
+    run([&](infiniverse& c) { c.depositinf(alice, self, asset(asset::max_amount, inf), ""); });
+
+    eosio::host::counters = eosio::host::db_counters{};
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = land_count; i < cells.size(); i++)
+    {
+        double south = cells[i].row * cell_micro_degrees / 1e6;
+        double west = cells[i].col * cell_micro_degrees / 1e6;
+        double size = land_micro_degrees / 1e6;
+        run([&](infiniverse& c) { c.registerland(alice, south + size, west + size, south, west); });
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    bench_result result;
+    result.rows_read = double(eosio::host::counters.row_reads) / measured_registrations;
+    result.index_seeks = double(eosio::host::counters.index_seeks) / measured_registrations;
+    result.microseconds = std::chrono::duration<double, std::micro>(elapsed).count() / measured_registrations;
+    result.ram_bytes_per_land = double(table_ram) / land_count;
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    size_t max_lands = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    std::printf("%9s  %-9s  %9s  %11s  %8s  %14s\n", "lands", "layout", "rows/reg", "seeks/reg", "us/reg",
+        "RAM bytes/land");
+    for(size_t land_count = 10000; land_count <= max_lands; land_count *= 10)
+    {
+        for(land_layout layout : {land_layout::uniform, land_layout::clustered, land_layout::stripe})
+        {
+            bench_result result = measure(layout, land_count);
+            std::printf("%9zu  %-9s  %9.1f  %11.1f  %8.2f  %14.1f\n", land_count, layout_name(layout),
+                result.rows_read, result.index_seeks, result.microseconds, result.ram_bytes_per_land);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "eosio.hpp"
+
+namespace eosio {
+
+   class symbol_code {
+      public:
+         constexpr symbol_code() = default;
+         constexpr explicit symbol_code( uint64_t raw ) :value(raw) {}
+         constexpr explicit symbol_code( const char* str ) {
+            for( int i = 0; str[i]; ++i ) {
+               value |= uint64_t(uint8_t(str[i])) << (8 * i);
+            }
+         }
+
+         constexpr uint64_t raw()const { return value; }
+         constexpr bool is_valid()const {
+            uint64_t sym = value;
+            for( int i = 0; i < 7; i++ ) {
+               char c = char(sym & 0xFF);
+               if( !('A' <= c && c <= 'Z') ) return false;
+               sym >>= 8;
+               if( !(sym & 0xFF) ) {
+                  do {
+                     sym >>= 8;
+                     if( (sym & 0xFF) ) return false;
+                     i++;
+                  } while( i < 7 );
+               }
+            }
+            return value != 0;
+         }
+
+         friend constexpr bool operator == ( symbol_code a, symbol_code b ) { return a.value == b.value; }
+         friend constexpr bool operator != ( symbol_code a, symbol_code b ) { return a.value != b.value; }
+
+      private:
+         uint64_t value = 0;
+   };
+
+   class symbol {
+      public:
+         constexpr symbol() = default;
+         constexpr explicit symbol( uint64_t raw ) :value(raw) {}
+         constexpr symbol( symbol_code sc, uint8_t precision ) :value(sc.raw() << 8 | precision) {}
+         constexpr symbol( const char* str, uint8_t precision ) :symbol(symbol_code(str), precision) {}
+
+         constexpr uint64_t raw()const { return value; }
+         constexpr uint8_t precision()const { return value & 0xFF; }
+         constexpr symbol_code code()const { return symbol_code{value >> 8}; }
+         constexpr bool is_valid()const { return code().is_valid(); }
+
+         friend constexpr bool operator == ( symbol a, symbol b ) { return a.value == b.value; }
+         friend constexpr bool operator != ( symbol a, symbol b ) { return a.value != b.value; }
+
+      private:
+         uint64_t value = 0;
+   };
+
+   struct asset {
+      static constexpr int64_t max_amount = (1LL << 62) - 1;
+
+      int64_t       amount = 0;
+      eosio::symbol symbol;
+
+      asset() = default;
+      asset( int64_t a, eosio::symbol s ) :amount(a), symbol(s) {
+         eosio_assert( is_amount_within_range(), "magnitude of asset amount must be less than 2^62" );
+         eosio_assert( symbol.is_valid(), "invalid symbol name" );
+      }
+
+      bool is_amount_within_range()const { return -max_amount <= amount && amount <= max_amount; }
+      bool is_valid()const { return is_amount_within_range() && symbol.is_valid(); }
+
+      asset operator-()const { return asset( -amount, symbol ); }
+
+      asset& operator-=( const asset& a ) {
+         eosio_assert( a.symbol == symbol, "attempt to subtract asset with different symbol" );
+         amount -= a.amount;
+         eosio_assert( -max_amount <= amount, "subtraction underflow" );
+         eosio_assert( amount <= max_amount, "subtraction overflow" );
+         return *this;
+      }
+
+      asset& operator+=( const asset& a ) {
+         eosio_assert( a.symbol == symbol, "attempt to add asset with different symbol" );
+         amount += a.amount;
+         eosio_assert( -max_amount <= amount, "addition underflow" );
+         eosio_assert( amount <= max_amount, "addition overflow" );
+         return *this;
+      }
+
+      asset& operator*=( int64_t a ) {
+         int128_t tmp = (int128_t)amount * (int128_t)a;
+         eosio_assert( tmp <= max_amount, "multiplication overflow" );
+         eosio_assert( tmp >= -max_amount, "multiplication underflow" );
+         amount = (int64_t)tmp;
+         return *this;
+      }
+
+      friend asset operator+( const asset& a, const asset& b ) { asset result = a; result += b; return result; }
+      friend asset operator-( const asset& a, const asset& b ) { asset result = a; result -= b; return result; }
+      friend asset operator*( const asset& a, int64_t b ) { asset result = a; result *= b; return result; }
+
+      friend bool operator==( const asset& a, const asset& b ) {
+         eosio_assert( a.symbol == b.symbol, "comparison of assets with different symbols is not allowed" );
+         return a.amount == b.amount;
+      }
+      friend bool operator!=( const asset& a, const asset& b ) { return !(a == b); }
+      friend bool operator<( const asset& a, const asset& b ) {
+         eosio_assert( a.symbol == b.symbol, "comparison of assets with different symbols is not allowed" );
+         return a.amount < b.amount;
+      }
+      friend bool operator<=( const asset& a, const asset& b ) { return !(b < a); }
+      friend bool operator>( const asset& a, const asset& b ) { return b < a; }
+      friend bool operator>=( const asset& a, const asset& b ) { return !(a < b); }
+   };
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const symbol_code& v ) { return ds << v.raw(); }
+
+   inline datastream<const char*>& operator>>( datastream<const char*>& ds, symbol_code& v ) {
+      uint64_t raw = 0;
+      ds >> raw;
+      v = symbol_code( raw );
+      return ds;
+   }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const symbol& v ) { return ds << v.raw(); }
+
+   inline datastream<const char*>& operator>>( datastream<const char*>& ds, symbol& v ) {
+      uint64_t raw = 0;
+      ds >> raw;
+      v = symbol( raw );
+      return ds;
+   }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const asset& v ) { return ds << v.amount << v.symbol; }
+
+   inline datastream<const char*>& operator>>( datastream<const char*>& ds, asset& v ) { return ds >> v.amount >> v.symbol; }
+
+} /// namespace eosio
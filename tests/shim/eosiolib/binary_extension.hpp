@@ -0,0 +1,50 @@
+#pragma once
+
+#include <optional>
+
+#include "eosio.hpp"
+
+namespace eosio {
+
+   template<typename T>
+   class binary_extension {
+      public:
+         binary_extension() = default;
+         binary_extension( const T& v ) :_value(v) {}
+
+         bool has_value()const { return _value.has_value(); }
+
+         const T& value()const {
+            eosio_assert( _value.has_value(), "cannot get value of empty binary_extension" );
+            return *_value;
+         }
+
+         T value_or( const T& def = T() )const { return _value ? *_value : def; }
+
+         binary_extension& emplace( const T& v ) { _value = v; return *this; }
+         binary_extension& operator=( const T& v ) { _value = v; return *this; }
+
+         void reset() { _value.reset(); }
+
+      private:
+         std::optional<T> _value;
+   };
+
+   // Packed only when present, and read only when the row still has bytes left
+   template<typename Stream, typename T>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const binary_extension<T>& v ) {
+      if( v.has_value() ) ds << v.value();
+      return ds;
+   }
+
+   template<typename T>
+   datastream<const char*>& operator>>( datastream<const char*>& ds, binary_extension<T>& v ) {
+      if( ds.remaining() ) {
+         T value{};
+         ds >> value;
+         v.emplace( value );
+      }
+      return ds;
+   }
+
+} /// namespace eosio
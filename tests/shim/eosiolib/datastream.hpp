@@ -0,0 +1,283 @@
+/**
+ *  Host stand-in for eosiolib serialization. Packs values in the chain's binary format:
+ *  little endian integers, varuint32 lengths, and aggregates field by field in declaration
+ *  order, which is what eosio-cpp generates for structs without EOSLIB_SERIALIZE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
+
+namespace eosio {
+
+   void check_stream( bool condition, const char* msg );
+
+   template<typename T>
+   class datastream;
+
+   template<>
+   class datastream<const char*> {
+      public:
+         datastream( const char* start, size_t size ) :_start(start), _pos(start), _end(start + size) {}
+
+         void read( char* d, size_t s ) {
+            check_stream( size_t(_end - _pos) >= s, "read" );
+            if( s ) std::memcpy( d, _pos, s );
+            _pos += s;
+         }
+
+         size_t remaining()const { return size_t(_end - _pos); }
+         size_t tellp()const { return size_t(_pos - _start); }
+
+      private:
+         const char* _start;
+         const char* _pos;
+         const char* _end;
+   };
+
+   template<>
+   class datastream<char*> {
+      public:
+         datastream( char* start, size_t size ) :_start(start), _pos(start), _end(start + size) {}
+
+         void write( const char* d, size_t s ) {
+            check_stream( size_t(_end - _pos) >= s, "write" );
+            if( s ) std::memcpy( _pos, d, s );
+            _pos += s;
+         }
+
+         size_t tellp()const { return size_t(_pos - _start); }
+
+      private:
+         char* _start;
+         char* _pos;
+         char* _end;
+   };
+
+   // Counts the bytes a value packs to
+   template<>
+   class datastream<size_t> {
+      public:
+         explicit datastream( size_t init = 0 ) :_size(init) {}
+
+         void write( const char*, size_t s ) { _size += s; }
+
+         size_t tellp()const { return _size; }
+
+      private:
+         size_t _size;
+   };
+
+   namespace reflect {
+      struct any_field {
+         template<typename T>
+         operator T()const;
+      };
+
+      template<typename T, typename Seq, typename = void>
+      struct brace_constructible : std::false_type {};
+
+      template<typename T, size_t... I>
+      struct brace_constructible<T, std::index_sequence<I...>,
+         std::void_t<decltype( T{ (void(I), any_field{})... } )>> : std::true_type {};
+
+      template<typename T, size_t N = 12>
+      constexpr size_t field_count() {
+         if constexpr( N == 0 ) return 0;
+         else if constexpr( brace_constructible<T, std::make_index_sequence<N>>::value ) return N;
+         else return field_count<T, N - 1>();
+      }
+
+      // Calls f on each field of an aggregate in declaration order
+      template<typename T, typename F>
+      void for_each_field( T& obj, F&& f ) {
+         constexpr size_t n = field_count<std::remove_const_t<T>>();
+         static_assert( n <= 12, "aggregate has too many fields to serialize" );
+         if constexpr( n == 1 ) { auto& [a] = obj; f(a); }
+         else if constexpr( n == 2 ) { auto& [a, b] = obj; f(a); f(b); }
+         else if constexpr( n == 3 ) { auto& [a, b, c] = obj; f(a); f(b); f(c); }
+         else if constexpr( n == 4 ) { auto& [a, b, c, d] = obj; f(a); f(b); f(c); f(d); }
+         else if constexpr( n == 5 ) { auto& [a, b, c, d, e] = obj; f(a); f(b); f(c); f(d); f(e); }
+         else if constexpr( n == 6 ) { auto& [a, b, c, d, e, g] = obj; f(a); f(b); f(c); f(d); f(e); f(g); }
+         else if constexpr( n == 7 ) {
+            auto& [a, b, c, d, e, g, h] = obj;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h);
+         }
+         else if constexpr( n == 8 ) {
+            auto& [a, b, c, d, e, g, h, i] = obj;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i);
+         }
+         else if constexpr( n == 9 ) {
+            auto& [a, b, c, d, e, g, h, i, j] = obj;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j);
+         }
+         else if constexpr( n == 10 ) {
+            auto& [a, b, c, d, e, g, h, i, j, k] = obj;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k);
+         }
+         else if constexpr( n == 11 ) {
+            auto& [a, b, c, d, e, g, h, i, j, k, l] = obj;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l);
+         }
+         else if constexpr( n == 12 ) {
+            auto& [a, b, c, d, e, g, h, i, j, k, l, m] = obj;
+            f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l); f(m);
+         }
+      }
+
+      template<typename T>
+      constexpr bool is_packed_aggregate = std::is_class_v<T> && std::is_aggregate_v<T> && !std::is_array_v<T>;
+   }
+
+   template<typename Stream, typename T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>* = nullptr>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const T& v ) {
+      ds.write( reinterpret_cast<const char*>( &v ), sizeof(v) );
+      return ds;
+   }
+
+   template<typename T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>* = nullptr>
+   datastream<const char*>& operator>>( datastream<const char*>& ds, T& v ) {
+      ds.read( reinterpret_cast<char*>( &v ), sizeof(v) );
+      return ds;
+   }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const uint128_t& v ) {
+      ds.write( reinterpret_cast<const char*>( &v ), sizeof(v) );
+      return ds;
+   }
+
+   inline datastream<const char*>& operator>>( datastream<const char*>& ds, uint128_t& v ) {
+      ds.read( reinterpret_cast<char*>( &v ), sizeof(v) );
+      return ds;
+   }
+
+   // Lengths are varuint32, seven bits per byte with the high bit marking continuation
+   template<typename Stream>
+   void pack_length( datastream<Stream>& ds, uint32_t length ) {
+      do {
+         uint8_t b = uint8_t(length & 0x7F);
+         length >>= 7;
+         b |= uint8_t(length > 0) << 7;
+         ds.write( reinterpret_cast<const char*>( &b ), 1 );
+      } while( length );
+   }
+
+   inline uint32_t unpack_length( datastream<const char*>& ds ) {
+      uint32_t length = 0;
+      uint8_t b = 0;
+      int by = 0;
+      do {
+         ds.read( reinterpret_cast<char*>( &b ), 1 );
+         length |= uint32_t(b & 0x7F) << by;
+         by += 7;
+      } while( (b & 0x80) && by < 32 );
+      return length;
+   }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::string& v ) {
+      pack_length( ds, uint32_t(v.size()) );
+      ds.write( v.data(), v.size() );
+      return ds;
+   }
+
+   inline datastream<const char*>& operator>>( datastream<const char*>& ds, std::string& v ) {
+      v.resize( unpack_length( ds ) );
+      ds.read( v.data(), v.size() );
+      return ds;
+   }
+
+   template<typename Stream, typename T>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::vector<T>& v ) {
+      pack_length( ds, uint32_t(v.size()) );
+      for( const T& element : v ) ds << element;
+      return ds;
+   }
+
+   template<typename T>
+   datastream<const char*>& operator>>( datastream<const char*>& ds, std::vector<T>& v ) {
+      uint32_t length = unpack_length( ds );
+      v.clear();
+      v.reserve( std::min<size_t>( length, ds.remaining() ) );
+      for( uint32_t i = 0; i < length; ++i ) {
+         T element{};
+         ds >> element;
+         v.push_back( std::move( element ) );
+      }
+      return ds;
+   }
+
+   template<typename Stream, typename A, typename B>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::pair<A, B>& v ) {
+      return ds << v.first << v.second;
+   }
+
+   template<typename A, typename B>
+   datastream<const char*>& operator>>( datastream<const char*>& ds, std::pair<A, B>& v ) {
+      return ds >> v.first >> v.second;
+   }
+
+   template<typename Stream, typename... T>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::tuple<T...>& v ) {
+      std::apply( [&]( const auto&... elements ) { (void)( ds << ... << elements ); }, v );
+      return ds;
+   }
+
+   template<typename... T>
+   datastream<const char*>& operator>>( datastream<const char*>& ds, std::tuple<T...>& v ) {
+      std::apply( [&]( auto&... elements ) { (void)( ds >> ... >> elements ); }, v );
+      return ds;
+   }
+
+   template<typename Stream, typename T, std::enable_if_t<reflect::is_packed_aggregate<T>>* = nullptr>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const T& v ) {
+      reflect::for_each_field( v, [&]( const auto& field ) { ds << field; } );
+      return ds;
+   }
+
+   template<typename T, std::enable_if_t<reflect::is_packed_aggregate<T>>* = nullptr>
+   datastream<const char*>& operator>>( datastream<const char*>& ds, T& v ) {
+      reflect::for_each_field( v, [&]( auto& field ) { ds >> field; } );
+      return ds;
+   }
+
+   template<typename T>
+   size_t pack_size( const T& value ) {
+      datastream<size_t> ps;
+      ps << value;
+      return ps.tellp();
+   }
+
+   template<typename T>
+   std::vector<char> pack( const T& value ) {
+      std::vector<char> result( pack_size( value ) );
+      datastream<char*> ds( result.data(), result.size() );
+      ds << value;
+      return result;
+   }
+
+   // Trailing bytes are ignored, as on chain when a row is read with an older, shorter layout
+   template<typename T>
+   T unpack( const char* buffer, size_t size ) {
+      T result{};
+      datastream<const char*> ds( buffer, size );
+      ds >> result;
+      return result;
+   }
+
+   template<typename T>
+   T unpack( const std::vector<char>& bytes ) {
+      return unpack<T>( bytes.data(), bytes.size() );
+   }
+
+} /// namespace eosio
@@ -0,0 +1,546 @@
+/**
+ *  Host stand-in for the parts of eosiolib the contracts use, so they compile unchanged and run
+ *  natively in tests. Tables keep packed rows in process memory, laid out and billed like the
+ *  chain's, and inline actions are recorded with their packed data, not executed.
+ */
+#pragma once
+
+#include <algorithm>
+#include <any>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#include "datastream.hpp"
+
+namespace eosio {
+
+   // Thrown where the chain would abort the transaction
+   struct assert_failure : std::runtime_error {
+      using std::runtime_error::runtime_error;
+   };
+
+} /// namespace eosio
+
+inline void eosio_assert( bool condition, const char* msg ) {
+   if( !condition ) throw eosio::assert_failure( msg );
+}
+
+namespace eosio {
+
+   inline void check_stream( bool condition, const char* msg ) { eosio_assert( condition, msg ); }
+
+   struct name {
+      enum class raw : uint64_t {};
+
+      constexpr name() = default;
+      constexpr explicit name( uint64_t v ) : value(v) {}
+      constexpr explicit name( raw r ) : value(static_cast<uint64_t>(r)) {}
+      constexpr explicit name( const char* str, size_t length ) {
+         size_t i = 0;
+         for( ; i < length && i < 12; ++i ) {
+            value <<= 5;
+            value |= char_to_value( str[i] );
+         }
+         value <<= 4 + 5 * (12 - i);
+         if( length == 13 ) {
+            value |= char_to_value( str[12] ) & 0x0F;
+         }
+      }
+      explicit name( const std::string& str ) : name( str.data(), str.size() ) {}
+
+      static constexpr uint8_t char_to_value( char c ) {
+         if( c >= '1' && c <= '5' ) return c - '1' + 1;
+         if( c >= 'a' && c <= 'z' ) return c - 'a' + 6;
+         return 0;
+      }
+
+      std::string to_string()const {
+         static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+         std::string str( 13, '.' );
+         uint64_t tmp = value;
+         for( uint32_t i = 0; i <= 12; ++i ) {
+            str[12 - i] = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+            tmp >>= (i == 0 ? 4 : 5);
+         }
+         str.erase( str.find_last_not_of( '.' ) + 1 );
+         return str;
+      }
+
+      constexpr operator raw()const { return raw(value); }
+      constexpr explicit operator bool()const { return value != 0; }
+
+      friend constexpr bool operator == ( name a, name b ) { return a.value == b.value; }
+      friend constexpr bool operator != ( name a, name b ) { return a.value != b.value; }
+      friend constexpr bool operator < ( name a, name b ) { return a.value < b.value; }
+
+      uint64_t value = 0;
+   };
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const name& v ) { return ds << v.value; }
+
+   inline datastream<const char*>& operator>>( datastream<const char*>& ds, name& v ) { return ds >> v.value; }
+
+   template <typename T, T... Str>
+   inline constexpr name operator""_n() {
+      constexpr char str[] = { Str..., 0 };
+      return name( str, sizeof...(Str) );
+   }
+
+   struct permission_level {
+      name actor;
+      name permission;
+   };
+
+   namespace host {
+      struct sent_action {
+         name              account;
+         name              action;
+         std::any          data;
+         std::vector<char> packed_data;
+      };
+
+      // What the chain bills for a row on top of its packed size, and for each secondary index entry
+      inline constexpr int64_t row_overhead_bytes = 108;
+      inline constexpr int64_t index_entry_overhead_bytes = 120;
+
+      template<typename Key>
+      constexpr int64_t index_entry_bytes() { return index_entry_overhead_bytes + int64_t(sizeof(Key)); }
+
+      struct secondary_index_base {
+         virtual ~secondary_index_base() = default;
+      };
+
+      template<typename Key>
+      struct secondary_index : secondary_index_base {
+         std::set<std::pair<Key, uint64_t>>  entries;
+         std::map<uint64_t, Key>             by_primary;
+      };
+
+      struct stored_row {
+         std::vector<char>  data;
+         name               payer;
+      };
+
+      struct table {
+         std::map<uint64_t, stored_row> rows;
+         // Like the chain, every index position and key type has its own index table, so a row written
+         // with an older layout keeps its old index entries until it is erased
+         std::map<std::pair<size_t, std::type_index>, std::unique_ptr<secondary_index_base>> indexes;
+
+         template<typename Key>
+         secondary_index<Key>& index( size_t position ) {
+            auto& entry = indexes[{ position, std::type_index( typeid(Key) ) }];
+            if( !entry ) entry = std::make_unique<secondary_index<Key>>();
+            return static_cast<secondary_index<Key>&>( *entry );
+         }
+      };
+
+      // Database calls made so far, reset with the chain
+      struct db_counters {
+         uint64_t row_reads = 0;
+         uint64_t row_writes = 0;
+         uint64_t index_seeks = 0;
+      };
+
+      inline uint32_t                   now_seconds = 0;
+      inline std::vector<name>          authorizations;
+      inline std::vector<name>          recipients;
+      inline std::vector<sent_action>   sent_actions;
+      inline std::vector<char>          action_data;
+      inline db_counters                counters;
+      // RAM bytes billed to each account by rows and index entries
+      inline std::map<uint64_t, int64_t> ram_usage;
+
+      // Keyed by code, scope and table name, shared by every handle opened on the same table
+      inline std::map<std::tuple<uint64_t, uint64_t, uint64_t>, table>& tables() {
+         static std::map<std::tuple<uint64_t, uint64_t, uint64_t>, table> t;
+         return t;
+      }
+
+      inline size_t row_count( name code, uint64_t scope, name table ) {
+         auto it = tables().find( { code.value, scope, table.value } );
+         return it == tables().end() ? 0 : it->second.rows.size();
+      }
+
+      inline int64_t ram_of( name account ) {
+         auto it = ram_usage.find( account.value );
+         return it == ram_usage.end() ? 0 : it->second;
+      }
+
+      inline void reset() {
+         now_seconds = 0;
+         authorizations.clear();
+         recipients.clear();
+         sent_actions.clear();
+         action_data.clear();
+         counters = db_counters{};
+         ram_usage.clear();
+         tables().clear();
+      }
+   }
+
+   inline void require_auth( name n ) {
+      for( const name& a : host::authorizations )
+         if( a == n ) return;
+      throw assert_failure( "missing authority of " + n.to_string() );
+   }
+
+   inline bool has_auth( name n ) {
+      for( const name& a : host::authorizations )
+         if( a == n ) return true;
+      return false;
+   }
+
+   inline bool is_account( name ) { return true; }
+
+   inline void require_recipient( name n ) { host::recipients.push_back( n ); }
+
+   namespace host {
+      // The chain only lets a contract grow another account's RAM when that account authorized the action
+      inline void bill_ram( name code, name payer, int64_t delta ) {
+         if( delta > 0 && payer != code ) require_auth( payer );
+         ram_usage[payer.value] += delta;
+      }
+   }
+
+   struct action {
+      template<typename T>
+      action( const permission_level& auth, name account, name act, T&& data )
+      :sent{ account, act, std::any( std::decay_t<T>( data ) ), pack( data ) } { (void)auth; }
+
+      template<typename T>
+      action( const std::vector<permission_level>& auths, name account, name act, T&& data )
+      :sent{ account, act, std::any( std::decay_t<T>( data ) ), pack( data ) } { (void)auths; }
+
+      void send()const { host::sent_actions.push_back( sent ); }
+
+      host::sent_action sent;
+   };
+
+   class contract {
+      public:
+         contract( name receiver, name code, datastream<const char*> ds ) :_self(receiver), _code(code), _ds(ds) {}
+
+         name get_self()const { return _self; }
+         name get_code()const { return _code; }
+
+      protected:
+         name _self;
+         name _code;
+         datastream<const char*> _ds;
+   };
+
+   inline constexpr name same_payer{};
+
+   template<name::raw IndexName, typename Extractor>
+   struct indexed_by {
+      static constexpr uint64_t index_name = static_cast<uint64_t>(IndexName);
+      typedef Extractor extractor;
+   };
+
+   template<class Class, class Type, Type (Class::*PtrToMemberFunction)()const>
+   struct const_mem_fun {
+      typedef Type result_type;
+      result_type operator()( const Class& obj )const { return (obj.*PtrToMemberFunction)(); }
+   };
+
+   template<name::raw TableName, typename T, typename... Indices>
+   class multi_index {
+      private:
+         typedef std::map<uint64_t, host::stored_row>::const_iterator row_iterator;
+
+         template<typename Index>
+         using key_type_of = typename Index::extractor::result_type;
+
+         template<typename Index>
+         static key_type_of<Index> extract( const T& obj ) {
+            return typename Index::extractor()( obj );
+         }
+
+         template<uint64_t IndexName, typename... I>
+         struct find_index;
+
+         template<uint64_t IndexName, typename I, typename... Rest>
+         struct find_index<IndexName, I, Rest...> {
+            typedef typename std::conditional<I::index_name == IndexName,
+               std::integral_constant<size_t, 0>,
+               std::integral_constant<size_t, 1 + find_index<IndexName, Rest...>::value>>::type type;
+            static constexpr size_t value = type::value;
+         };
+
+         template<uint64_t IndexName>
+         struct find_index<IndexName> {
+            static constexpr size_t value = 0;
+         };
+
+         template<typename F>
+         static void for_each_index( F&& f ) {
+            for_each_index_at( std::forward<F>( f ), std::index_sequence_for<Indices...>() );
+         }
+
+         template<typename F, size_t... Position>
+         static void for_each_index_at( F&& f, std::index_sequence<Position...> ) {
+            (f( std::integral_constant<size_t, Position>(), (Indices*)nullptr ), ...);
+         }
+
+         name          _code;
+         host::table*  _table;
+         // Rows this handle has read, like the chain's multi_index every row is unpacked at most once
+         mutable std::map<uint64_t, std::unique_ptr<T>> _cache;
+
+         const T& load( uint64_t pk )const {
+            auto cached = _cache.find( pk );
+            if( cached != _cache.end() ) return *cached->second;
+            auto row = _table->rows.find( pk );
+            eosio_assert( row != _table->rows.end(), "unable to find key" );
+            host::counters.row_reads++;
+            auto obj = std::make_unique<T>( unpack<T>( row->second.data ) );
+            return *_cache.emplace( pk, std::move( obj ) ).first->second;
+         }
+
+      public:
+         multi_index( name code, uint64_t scope )
+         :_code(code), _table(&host::tables()[{ code.value, scope, static_cast<uint64_t>(TableName) }]) {}
+
+         multi_index( const multi_index& ) = delete;
+         multi_index( multi_index&& ) = default;
+
+         struct const_iterator {
+            const multi_index*  _mi = nullptr;
+            row_iterator        _itr;
+
+            const T& operator*()const { return _mi->load( _itr->first ); }
+            const T* operator->()const { return &_mi->load( _itr->first ); }
+            const_iterator& operator++() { ++_itr; return *this; }
+            const_iterator operator++(int) { const_iterator copy = *this; ++_itr; return copy; }
+            const_iterator& operator--() { --_itr; return *this; }
+            bool operator==( const const_iterator& other )const { return _itr == other._itr; }
+            bool operator!=( const const_iterator& other )const { return _itr != other._itr; }
+         };
+
+         const_iterator begin()const { host::counters.index_seeks++; return { this, _table->rows.begin() }; }
+         const_iterator end()const { return { this, _table->rows.end() }; }
+         const_iterator find( uint64_t pk )const {
+            host::counters.index_seeks++;
+            return { this, _table->rows.find( pk ) };
+         }
+         const_iterator lower_bound( uint64_t pk )const {
+            host::counters.index_seeks++;
+            return { this, _table->rows.lower_bound( pk ) };
+         }
+         const_iterator upper_bound( uint64_t pk )const {
+            host::counters.index_seeks++;
+            return { this, _table->rows.upper_bound( pk ) };
+         }
+         const_iterator iterator_to( const T& obj )const { return find( obj.primary_key() ); }
+
+         const T& get( uint64_t pk, const char* error_msg = "unable to find key" )const {
+            auto itr = find( pk );
+            eosio_assert( itr != end(), error_msg );
+            return *itr;
+         }
+
+         uint64_t available_primary_key()const {
+            return _table->rows.empty() ? 0 : _table->rows.rbegin()->first + 1;
+         }
+
+         template<typename Lambda>
+         const_iterator emplace( name payer, Lambda&& constructor ) {
+            eosio_assert( payer != same_payer, "must specify a valid account to pay for new record" );
+            auto obj = std::make_unique<T>();
+            constructor( *obj );
+            uint64_t pk = obj->primary_key();
+            eosio_assert( _table->rows.count( pk ) == 0,
+               "could not insert object, most likely a uniqueness constraint was violated" );
+
+            std::vector<char> data = pack( *obj );
+            host::bill_ram( _code, payer, host::row_overhead_bytes + int64_t(data.size()) );
+            host::counters.row_writes++;
+            for_each_index( [&]( auto position, auto* index ) {
+               typedef key_type_of<std::remove_pointer_t<decltype(index)>> key_type;
+               auto& keys = _table->index<key_type>( position );
+               key_type key = extract<std::remove_pointer_t<decltype(index)>>( *obj );
+               keys.entries.emplace( key, pk );
+               keys.by_primary[pk] = key;
+               host::bill_ram( _code, payer, host::index_entry_bytes<key_type>() );
+            } );
+
+            auto itr = _table->rows.emplace( pk, host::stored_row{ std::move( data ), payer } ).first;
+            _cache[pk] = std::move( obj );
+            return { this, itr };
+         }
+
+         template<typename Lambda>
+         void modify( const_iterator itr, name payer, Lambda&& updater ) {
+            eosio_assert( itr != end(), "cannot pass end iterator to modify" );
+            uint64_t pk = itr._itr->first;
+            T& obj = const_cast<T&>( load( pk ) );
+            T before = obj;
+            updater( obj );
+            eosio_assert( obj.primary_key() == pk, "updater cannot change primary key when modifying an object" );
+
+            host::stored_row& row = _table->rows.at( pk );
+            std::vector<char> data = pack( obj );
+            name new_payer = payer == same_payer ? row.payer : payer;
+            int64_t index_bytes = 0;
+            for_each_index( [&]( auto position, auto* index ) {
+               typedef std::remove_pointer_t<decltype(index)> index_type;
+               typedef key_type_of<index_type> key_type;
+               auto& keys = _table->index<key_type>( position );
+               auto entry = keys.by_primary.find( pk );
+               if( entry == keys.by_primary.end() ) return;
+               index_bytes += host::index_entry_bytes<key_type>();
+               key_type old_key = extract<index_type>( before );
+               key_type new_key = extract<index_type>( obj );
+               if( old_key == new_key ) return;
+               keys.entries.erase( { entry->second, pk } );
+               keys.entries.emplace( new_key, pk );
+               entry->second = new_key;
+            } );
+
+            int64_t old_bytes = host::row_overhead_bytes + int64_t(row.data.size()) + index_bytes;
+            int64_t new_bytes = host::row_overhead_bytes + int64_t(data.size()) + index_bytes;
+            if( new_payer != row.payer ) {
+               host::bill_ram( _code, row.payer, -old_bytes );
+               host::bill_ram( _code, new_payer, new_bytes );
+            } else {
+               host::bill_ram( _code, row.payer, new_bytes - old_bytes );
+            }
+            host::counters.row_writes++;
+            row.data = std::move( data );
+            row.payer = new_payer;
+         }
+
+         template<typename Lambda>
+         void modify( const T& obj, name payer, Lambda&& updater ) {
+            modify( iterator_to( obj ), payer, std::forward<Lambda>( updater ) );
+         }
+
+         const_iterator erase( const_iterator itr ) {
+            eosio_assert( itr != end(), "cannot pass end iterator to erase" );
+            uint64_t pk = itr._itr->first;
+            host::stored_row& row = _table->rows.at( pk );
+            int64_t bytes = host::row_overhead_bytes + int64_t(row.data.size());
+            for_each_index( [&]( auto position, auto* index ) {
+               typedef key_type_of<std::remove_pointer_t<decltype(index)>> key_type;
+               auto& keys = _table->index<key_type>( position );
+               auto entry = keys.by_primary.find( pk );
+               if( entry == keys.by_primary.end() ) return;
+               keys.entries.erase( { entry->second, pk } );
+               keys.by_primary.erase( entry );
+               bytes += host::index_entry_bytes<key_type>();
+            } );
+            host::bill_ram( _code, row.payer, -bytes );
+            host::counters.row_writes++;
+            _cache.erase( pk );
+            return { this, _table->rows.erase( itr._itr ) };
+         }
+
+         void erase( const T& obj ) { erase( iterator_to( obj ) ); }
+
+         template<typename Index, size_t Position>
+         class index {
+            public:
+               typedef key_type_of<Index> key_type;
+               typedef typename std::set<std::pair<key_type, uint64_t>>::const_iterator set_iterator;
+
+               explicit index( multi_index* table ) :_table(table), _keys(&table->_table->template index<key_type>( Position )) {}
+
+               struct const_iterator {
+                  const multi_index*  _table = nullptr;
+                  set_iterator        _itr;
+
+                  const T& operator*()const { return _table->load( _itr->second ); }
+                  const T* operator->()const { return &_table->load( _itr->second ); }
+                  const_iterator& operator++() { ++_itr; return *this; }
+                  const_iterator operator++(int) { const_iterator copy = *this; ++_itr; return copy; }
+                  const_iterator& operator--() { --_itr; return *this; }
+                  bool operator==( const const_iterator& other )const { return _itr == other._itr; }
+                  bool operator!=( const const_iterator& other )const { return _itr != other._itr; }
+               };
+
+               const_iterator begin()const { host::counters.index_seeks++; return { _table, _keys->entries.begin() }; }
+               const_iterator end()const { return { _table, _keys->entries.end() }; }
+               const_iterator lower_bound( const key_type& key )const {
+                  host::counters.index_seeks++;
+                  return { _table, _keys->entries.lower_bound( { key, 0 } ) };
+               }
+               const_iterator upper_bound( const key_type& key )const {
+                  host::counters.index_seeks++;
+                  return { _table, _keys->entries.upper_bound( { key, UINT64_MAX } ) };
+               }
+               const_iterator find( const key_type& key )const {
+                  auto itr = lower_bound( key );
+                  if( itr != end() && itr._itr->first == key ) return itr;
+                  return end();
+               }
+               const_iterator iterator_to( const T& obj )const {
+                  return { _table, _keys->entries.find( { extract<Index>( obj ), obj.primary_key() } ) };
+               }
+
+               template<typename Lambda>
+               void modify( const_iterator itr, name payer, Lambda&& updater ) {
+                  eosio_assert( itr != end(), "cannot pass end iterator to modify" );
+                  _table->modify( _table->find( itr._itr->second ), payer, std::forward<Lambda>( updater ) );
+               }
+
+               const_iterator erase( const_iterator itr ) {
+                  eosio_assert( itr != end(), "cannot pass end iterator to erase" );
+                  const_iterator next = itr;
+                  ++next;
+                  _table->erase( _table->find( itr._itr->second ) );
+                  return next;
+               }
+
+            private:
+               multi_index*                         _table;
+               host::secondary_index<key_type>*     _keys;
+         };
+
+         template<name::raw IndexName>
+         auto get_index() {
+            constexpr size_t position = find_index<static_cast<uint64_t>(IndexName), Indices...>::value;
+            static_assert( position < sizeof...(Indices), "name not found in indices" );
+            typedef typename std::tuple_element<position, std::tuple<Indices...>>::type index_type;
+            return index<index_type, position>( this );
+         }
+   };
+
+   template<typename T, typename... Args>
+   bool execute_action( name, name, void (T::*)(Args...) ) { return true; }
+
+} /// namespace eosio
+
+inline uint32_t now() { return eosio::host::now_seconds; }
+
+inline uint32_t action_data_size() { return static_cast<uint32_t>(eosio::host::action_data.size()); }
+
+inline uint32_t read_action_data( void* msg, uint32_t len ) {
+   uint32_t size = std::min( len, action_data_size() );
+   std::memcpy( msg, eosio::host::action_data.data(), size );
+   return size;
+}
+
+using eosio::operator""_n;
+
+#define CONTRACT class [[eosio::contract]]
+#define ACTION [[eosio::action]] void
+#define TABLE struct [[eosio::table]]
+
+#define EOSIO_DISPATCH_HELPER( TYPE, MEMBERS )
+#define EOSIO_DISPATCH( TYPE, MEMBERS )
+
+// Records the inline action without its data, the arguments are an untyped initializer list
+#define SEND_INLINE_ACTION( CONTRACT, NAME, ... ) \
+   eosio::host::sent_actions.push_back( eosio::host::sent_action{ (CONTRACT).get_self(), eosio::name(#NAME, sizeof(#NAME) - 1), {}, {} } )
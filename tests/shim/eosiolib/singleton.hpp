@@ -0,0 +1,49 @@
+#pragma once
+
+#include "eosio.hpp"
+
+namespace eosio {
+
+   template<name::raw SingletonName, typename T>
+   class singleton {
+      private:
+         static constexpr uint64_t pk_value = static_cast<uint64_t>(SingletonName);
+
+         struct row {
+            T value;
+
+            uint64_t primary_key()const { return pk_value; }
+         };
+
+         multi_index<SingletonName, row> _t;
+
+      public:
+         singleton( name code, uint64_t scope ) :_t(code, scope) {}
+
+         bool exists() { return _t.find( pk_value ) != _t.end(); }
+
+         T get() { return _t.get( pk_value, "singleton does not exist" ).value; }
+
+         T get_or_default( const T& def = T() ) {
+            auto itr = _t.find( pk_value );
+            return itr != _t.end() ? itr->value : def;
+         }
+
+         void set( const T& value, name bill_to_account ) {
+            auto itr = _t.find( pk_value );
+            if( itr != _t.end() ) {
+               _t.modify( itr, bill_to_account, [&]( row& r ) { r.value = value; } );
+            } else {
+               _t.emplace( bill_to_account, [&]( row& r ) { r.value = value; } );
+            }
+         }
+
+         void remove() {
+            auto itr = _t.find( pk_value );
+            if( itr != _t.end() ) {
+               _t.erase( itr );
+            }
+         }
+   };
+
+} /// namespace eosio
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "eosio.hpp"
+
+namespace eosio {
+
+   class time_point_sec {
+      public:
+         time_point_sec() = default;
+         explicit time_point_sec( uint32_t seconds ) :utc_seconds(seconds) {}
+
+         uint32_t sec_since_epoch()const { return utc_seconds; }
+
+         friend bool operator==( const time_point_sec& a, const time_point_sec& b ) { return a.utc_seconds == b.utc_seconds; }
+         friend bool operator!=( const time_point_sec& a, const time_point_sec& b ) { return a.utc_seconds != b.utc_seconds; }
+         friend bool operator<( const time_point_sec& a, const time_point_sec& b ) { return a.utc_seconds < b.utc_seconds; }
+         friend bool operator<=( const time_point_sec& a, const time_point_sec& b ) { return a.utc_seconds <= b.utc_seconds; }
+
+         uint32_t utc_seconds = 0;
+   };
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const time_point_sec& v ) { return ds << v.utc_seconds; }
+
+   inline datastream<const char*>& operator>>( datastream<const char*>& ds, time_point_sec& v ) { return ds >> v.utc_seconds; }
+
+} /// namespace eosio
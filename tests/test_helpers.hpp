@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Minimal checks so the host tests need nothing beyond the standard library
+inline int test_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) \
+        { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            test_failures++; \
+        } \
+    } while(0)
+
+// Checks that the statement fails an eosio_assert with exactly the given message
+#define CHECK_ASSERT(statement, message) \
+    do { \
+        const char* failure = nullptr; \
+        std::string what; \
+        try \
+        { \
+            statement; \
+            failure = "no assert"; \
+        } \
+        catch(const eosio::assert_failure& e) \
+        { \
+            what = e.what(); \
+            if(what != (message)) \
+                failure = what.c_str(); \
+        } \
+        if(failure) \
+        { \
+            std::printf("%s:%d: %s expected \"%s\" got \"%s\"\n", __FILE__, __LINE__, #statement, \
+                (message), failure); \
+            test_failures++; \
+        } \
+    } while(0)
+
+// Checks that the statement throws a std::runtime_error, as the off chain tools do on bad input
+#define CHECK_THROWS(statement) \
+    do { \
+        bool thrown = false; \
+        try \
+        { \
+            statement; \
+        } \
+        catch(const std::runtime_error&) \
+        { \
+            thrown = true; \
+        } \
+        if(!thrown) \
+        { \
+            std::printf("%s:%d: %s did not throw\n", __FILE__, __LINE__, #statement); \
+            test_failures++; \
+        } \
+    } while(0)
+
+inline int report_tests(const char* suite)
+{
+    if(test_failures == 0)
+    {
+        std::printf("%s passed\n", suite);
+        return 0;
+    }
+    std::printf("%s: %d checks failed\n", suite, test_failures);
+    return 1;
+}
@@ -0,0 +1,94 @@
+#include "eosio.token.hpp"
+
+#include "test_helpers.hpp"
+
+using eosio::asset;
+using eosio::name;
+using eosio::symbol;
+using eosio::symbol_code;
+
+const name token_account = "infinicoinio"_n;
+const name alice = "alice"_n;
+const name bob = "bob"_n;
+const name carol = "carol"_n;
+const symbol inf = symbol("INF", 4);
+
+template<typename F>
+void run(F&& action)
+{
+    eosio::token contract(token_account, token_account, eosio::datastream<const char*>(nullptr, 0));
+    action(contract);
+}
+
+asset inf_amount(int64_t whole_inf)
+{
+    return asset(whole_inf * 10000, inf);
+}
+
+asset balance(name owner)
+{
+    return eosio::token::get_balance(token_account, owner, inf.code());
+}
+
+// Alice starts with 1000 INF
+void reset_chain()
+{
+    eosio::host::reset();
+    eosio::host::authorizations = {token_account, alice};
+    run([&](eosio::token& c) { c.create(token_account, inf_amount(1000000)); });
+    run([&](eosio::token& c) { c.issue(token_account, inf_amount(1000), ""); });
+    run([&](eosio::token& c) { c.transfer(token_account, alice, inf_amount(1000), ""); });
+    eosio::host::authorizations = {alice};
+}
+
+void test_transfermany_debits_once()
+{
+    reset_chain();
+    eosio::host::counters = eosio::host::db_counters{};
+    run([&](eosio::token& c) {
+        c.transfermany(alice, {{bob, inf_amount(1)}, {carol, inf_amount(2)}, {bob, inf_amount(3)}}, "");
+    });
+    CHECK(balance(alice) == inf_amount(994));
+    // One write debits the sender, the others create or credit the recipients
+    CHECK(eosio::host::counters.row_writes == 4);
+
+    // The batch total is checked against the balance, not each transfer on its own
+    CHECK_ASSERT(run([&](eosio::token& c) {
+        c.transfermany(alice, {{bob, inf_amount(500)}, {carol, inf_amount(500)}}, "");
+    }), "overdrawn balance");
+    CHECK(balance(alice) == inf_amount(994));
+}
+
+void test_transfermany_credits_duplicates()
+{
+    reset_chain();
+    run([&](eosio::token& c) {
+        c.transfermany(alice, {{bob, inf_amount(1)}, {carol, inf_amount(2)}, {bob, inf_amount(3)}}, "");
+    });
+    CHECK(balance(bob) == inf_amount(4));
+    CHECK(balance(carol) == inf_amount(2));
+}
+
+void test_transfermany_rejects_mixed_symbols()
+{
+    reset_chain();
+    CHECK_ASSERT(run([&](eosio::token& c) {
+        c.transfermany(alice, {{bob, inf_amount(1)}, {carol, asset(100, symbol("INF", 2))}}, "");
+    }), "all transfers must use the same symbol");
+    CHECK_ASSERT(run([&](eosio::token& c) {
+        c.transfermany(alice, {{bob, inf_amount(1)}, {carol, asset(10000, symbol("EOS", 4))}}, "");
+    }), "all transfers must use the same symbol");
+    CHECK_ASSERT(run([&](eosio::token& c) { c.transfermany(alice, {}, ""); }), "no transfers given");
+    CHECK_ASSERT(run([&](eosio::token& c) { c.transfermany(alice, {{alice, inf_amount(1)}}, ""); }),
+        "cannot transfer to self");
+    CHECK(balance(alice) == inf_amount(1000));
+    CHECK(eosio::host::row_count(token_account, bob.value, "accounts"_n) == 0);
+}
+
+int main()
+{
+    test_transfermany_debits_once();
+    test_transfermany_credits_duplicates();
+    test_transfermany_rejects_mixed_symbols();
+    return report_tests("token_tests");
+}
@@ -0,0 +1,91 @@
+#include "transform_encoding.hpp"
+
+#include "test_helpers.hpp"
+
+#include <cmath>
+
+struct vector3 {
+    double x;
+    double y;
+    double z;
+};
+
+void test_round_trip()
+{
+    // Decoding lands within half a step of the encoded value
+    for(double position = 0.001; position < 1; position += 0.0137)
+    {
+        CHECK(std::fabs(decode_position(encode_position(position)) - position) <= 0.5 / transform_position_steps);
+    }
+    for(double degrees = 0; degrees < 360; degrees += 7.3)
+    {
+        CHECK(std::fabs(decode_angle(encode_angle(degrees)) - degrees) <= 180 / transform_angle_steps);
+    }
+    double scale_step = std::exp2(0.5 / transform_scale_steps_per_doubling);
+    for(double scale = 0.2; scale < 1000; scale *= 1.37)
+    {
+        double decoded = decode_scale(encode_scale(scale));
+        CHECK(decoded <= scale * scale_step && decoded >= scale / scale_step);
+    }
+
+    // Every encoded value decodes and encodes back to itself
+    for(uint32_t value = 1; value < 65536; value += 97)
+    {
+        CHECK(encode_position(decode_position(value)) == value);
+        CHECK(encode_angle(decode_angle(value)) == value);
+        CHECK(encode_scale(decode_scale(value)) == value);
+    }
+
+    vector3 position{0.25, 0, 0.75};
+    vector3 orientation{10, 200, 359};
+    vector3 scale{1, 2, 0.5};
+    compact_transform transform = encode_transform(position, orientation, scale);
+    vector3 decoded_position{}, decoded_orientation{}, decoded_scale{};
+    decode_transform(transform, decoded_position, decoded_orientation, decoded_scale);
+    CHECK(decoded_position.x == 0.25 && decoded_position.y == 0 && decoded_position.z == 0.75);
+    CHECK(std::fabs(decoded_orientation.y - 200) <= 180 / transform_angle_steps);
+    CHECK(std::fabs(decoded_scale.y - 2) <= 2 * (scale_step - 1));
+}
+
+void test_angle_wraparound()
+{
+    CHECK(encode_angle(360) == 0);
+    CHECK(encode_angle(720 + 45) == encode_angle(45));
+    CHECK(encode_angle(-90) == encode_angle(270));
+    CHECK(encode_angle(-360) == 0);
+    // Within half a step of 360 rounds up to a full turn, which is zero again
+    CHECK(encode_angle(359.999) == 0);
+    CHECK(encode_angle(360 - 360 / transform_angle_steps) == 65535);
+}
+
+void test_scale_clamped()
+{
+    CHECK(encode_scale(0.2) == 0);
+    CHECK(encode_scale(0.1) == 0);
+    CHECK(encode_scale(0) == 0);
+    CHECK(decode_scale(0) == transform_min_scale);
+    // 16 doublings above the minimum is the largest scale that can be stored
+    CHECK(encode_scale(transform_min_scale * std::exp2(16)) == 65535);
+    CHECK(encode_scale(1e9) == 65535);
+}
+
+void test_position_bounds()
+{
+    // Zero means out of bounds, so the land edges clamp to the first and last steps inside the land
+    CHECK(encode_position(0) == 1);
+    CHECK(encode_position(-0.5) == 1);
+    CHECK(encode_position(1) == 65535);
+    CHECK(encode_position(1.5) == 65535);
+    CHECK(encode_position(0.5) == 32768);
+    CHECK(decode_position(1) > 0);
+    CHECK(decode_position(65535) < 1);
+}
+
+int main()
+{
+    test_round_trip();
+    test_angle_wraparound();
+    test_scale_clamped();
+    test_position_bounds();
+    return report_tests("transform_encoding_tests");
+}
@@ -0,0 +1,54 @@
+#include "z_order_functions.cpp"
+
+#include "test_helpers.hpp"
+
+#include <random>
+
+void test_encode_round_trip()
+{
+    std::mt19937 rng(1);
+    for(int i = 0; i < 10000; i++)
+    {
+        uint32_t x = rng();
+        uint32_t y = rng();
+        uint64_t z_value = z_order_encode(x, y);
+        CHECK(z_order_x(z_value) == x);
+        CHECK(z_order_y(z_value) == y);
+    }
+    CHECK(z_order_encode(1, 0) == 1);
+    CHECK(z_order_encode(0, 1) == 2);
+}
+
+// Compares BIGMIN with walking every key up to z_max on small random boxes
+void test_next_in_box_matches_brute_force()
+{
+    std::mt19937 rng(2);
+    for(int box = 0; box < 300; box++)
+    {
+        uint32_t x1 = rng() % 64, x2 = rng() % 64;
+        uint32_t y1 = rng() % 64, y2 = rng() % 64;
+        uint64_t z_min = z_order_encode(std::min(x1, x2), std::min(y1, y2));
+        uint64_t z_max = z_order_encode(std::max(x1, x2), std::max(y1, y2));
+
+        for(uint64_t z_value = z_min; z_value <= z_max; z_value++)
+        {
+            if(z_order_in_box(z_value, z_min, z_max))
+            {
+                continue;
+            }
+            uint64_t expected = z_value + 1;
+            while(!z_order_in_box(expected, z_min, z_max))
+            {
+                expected++;
+            }
+            CHECK(z_order_next_in_box(z_value, z_min, z_max) == expected);
+        }
+    }
+}
+
+int main()
+{
+    test_encode_round_trip();
+    test_next_in_box_matches_brute_force();
+    return report_tests("z_order_tests");
+}
@@ -0,0 +1,84 @@
+#include "change_mirror.hpp"
+
+#include <stdexcept>
+#include <tuple>
+
+#include "snapshot_rows.hpp"
+
+namespace change_mirror {
+
+    void mirror::load(const land_snapshot::snapshot_view& snapshot)
+    {
+        for(const land_snapshot::land_record& record : snapshot.lands())
+        {
+            lands[record.id] = land_snapshot::to_row(record);
+        }
+        for(const land_snapshot::persistent_record& record : snapshot.persistents())
+        {
+            persistents[record.land_id][record.id] = land_snapshot::to_row(record);
+        }
+        for(const land_snapshot::poly_record& record : snapshot.polys())
+        {
+            polys[record.id] = land_snapshot::to_row(record);
+        }
+    }
+
+    void mirror::apply_action_data(const std::vector<char>& action_data)
+    {
+        // The action's only argument is the vector of records
+        std::vector<change_record> records = std::get<0>(eosio::unpack<std::tuple<std::vector<change_record>>>(action_data));
+        for(const change_record& record : records)
+        {
+            apply(record);
+        }
+    }
+
+    void mirror::apply(const change_record& record)
+    {
+        if(record.op != static_cast<uint8_t>(change_op::UPSERT) && record.op != static_cast<uint8_t>(change_op::ERASE))
+        {
+            throw std::runtime_error("Unknown change op " + std::to_string(record.op));
+        }
+        if(record.table == "land"_n)
+        {
+            apply_to(lands, record);
+        }
+        else if(record.table == "persistent"_n)
+        {
+            std::map<uint64_t, infiniverse_rows::persistent>& scope = persistents[record.scope];
+            apply_to(scope, record);
+            if(scope.empty())
+            {
+                persistents.erase(record.scope);
+            }
+        }
+        else if(record.table == "poly"_n)
+        {
+            apply_to(polys, record);
+        }
+        else
+        {
+            throw std::runtime_error("Change of unknown table " + record.table.to_string());
+        }
+    }
+
+    // Erasing a row the mirror never held is not an error, the contract also records erases of
+    // rows written before the upgrade, which were never sent as upserts
+    template<typename Row>
+    void mirror::apply_to(std::map<uint64_t, Row>& rows, const change_record& record)
+    {
+        if(record.op == static_cast<uint8_t>(change_op::ERASE))
+        {
+            rows.erase(record.id);
+            return;
+        }
+        Row row = eosio::unpack<Row>(record.row);
+        if(row.primary_key() != record.id)
+        {
+            throw std::runtime_error("Change of " + record.table.to_string() + " row " + std::to_string(record.id)
+                + " holds row " + std::to_string(row.primary_key()));
+        }
+        rows[record.id] = row;
+    }
+
+} /// namespace change_mirror
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "infiniverse_rows.hpp"
+#include "land_snapshot.hpp"
+
+// Keeps an in-memory copy of the land, persistent and poly tables current from the changes actions the
+// contract sends after every action, as an off-chain indexer reading the action traces does.
+namespace change_mirror {
+
+    // Same values as ChangeOp in the contract
+    enum class change_op : uint8_t
+    {
+        UPSERT,
+        ERASE
+    };
+
+    // Same layout as change_record in the contract, row holds the packed row after an upsert
+    struct change_record {
+        uint8_t op;
+        eosio::name table;
+        uint64_t scope;
+        uint64_t id;
+        std::vector<char> row;
+    };
+
+    class mirror {
+        public:
+            // Starts from the tables of a snapshot, changes sent after it was taken are applied on top
+            void load(const land_snapshot::snapshot_view& snapshot);
+
+            // Applies the records of one changes action from its packed action data, in order.
+            // Throws std::runtime_error on data that doesn't decode or a record of an unknown table
+            void apply_action_data(const std::vector<char>& action_data);
+            void apply(const change_record& record);
+
+            std::map<uint64_t, infiniverse_rows::land> lands;
+            // Keyed by land id, the scope of the persistent table
+            std::map<uint64_t, std::map<uint64_t, infiniverse_rows::persistent>> persistents;
+            std::map<uint64_t, infiniverse_rows::poly> polys;
+
+        private:
+            template<typename Row>
+            static void apply_to(std::map<uint64_t, Row>& rows, const change_record& record);
+    };
+
+} /// namespace change_mirror
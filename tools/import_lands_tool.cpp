@@ -0,0 +1,50 @@
+#include "land_import.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+// import_lands LANDS [SNAPSHOT|-] [BATCH_SIZE]
+//
+// Checks the lands in LANDS, one "owner north east south west" line each in micro degrees, against each
+// other and against the registered lands in SNAPSHOT, "-" for none. Prints the importlands action data
+// of each batch, one JSON object per line, or the first invalid land and exits with 1.
+int main(int argc, char** argv)
+{
+    if(argc < 2 || argc > 4)
+    {
+        std::fprintf(stderr, "usage: import_lands LANDS [SNAPSHOT|-] [BATCH_SIZE]\n");
+        return 2;
+    }
+    try
+    {
+        std::ifstream input(argv[1]);
+        if(!input)
+        {
+            throw std::runtime_error(std::string("Could not open ") + argv[1]);
+        }
+        std::vector<land_import::imported_land> lands = land_import::parse_lands(input);
+
+        std::unique_ptr<land_snapshot::snapshot_view> existing;
+        if(argc > 2 && std::string(argv[2]) != "-")
+        {
+            existing.reset(new land_snapshot::snapshot_view(argv[2]));
+        }
+        // Lands per action, small enough for the action to fit within a transaction's CPU limit
+        size_t batch_size = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100;
+
+        for(const auto& batch : land_import::plan_import(lands, existing.get(), batch_size))
+        {
+            std::printf("%s\n", land_import::batch_json(batch).c_str());
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::fprintf(stderr, "import_lands: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
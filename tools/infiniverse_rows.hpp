@@ -0,0 +1,94 @@
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/asset.hpp>
+#include <eosiolib/time.hpp>
+#include <eosiolib/singleton.hpp>
+#include <eosiolib/binary_extension.hpp>
+
+#include "lat_long_functions.cpp"
+#include "z_order_functions.cpp"
+#include "transform_encoding.hpp"
+#include "user_poly_hash.hpp"
+
+// The infiniverse table rows as clients see them. Fields, their order and the secondary indexes match
+// the tables in infiniverse/src/infiniverse.hpp, so packed rows from the chain or from change records
+// unpack into these structs, and the typedefs open the contract's own tables in the host harness.
+namespace infiniverse_rows {
+
+    using eosio::asset;
+    using eosio::name;
+
+    struct land {
+        uint64_t id;
+        name owner;
+        int32_t lat_north_edge;
+        int32_t long_east_edge;
+        int32_t lat_south_edge;
+        int32_t long_west_edge;
+        eosio::time_point_sec reg_end_date;
+
+        uint64_t primary_key() const { return id; }
+        uint64_t get_name() const { return owner.value; }
+        uint64_t get_reg_end_date() const { return reg_end_date.utc_seconds; }
+        uint64_t get_z_order_key() const
+        {
+            return z_order_encode(long_to_z_coord(long_west_edge), lat_to_z_coord(lat_south_edge));
+        }
+    };
+
+    typedef eosio::multi_index<"land"_n, land,
+        eosio::indexed_by<"byowner"_n, eosio::const_mem_fun<land, uint64_t, &land::get_name>>,
+        eosio::indexed_by<"byzorder"_n, eosio::const_mem_fun<land, uint64_t, &land::get_z_order_key>>,
+        eosio::indexed_by<"byexpiry"_n, eosio::const_mem_fun<land, uint64_t, &land::get_reg_end_date>>>
+        land_table;
+
+    // Scoped by land_id
+    struct persistent {
+        uint64_t id;
+        uint64_t land_id;
+        uint128_t source_and_asset_id;
+        compact_transform transform;
+
+        uint64_t primary_key() const { return id; }
+    };
+
+    typedef eosio::multi_index<"persistent"_n, persistent> persistent_table;
+
+    struct poly {
+        uint64_t id;
+        name user;
+        std::string poly_id;
+        eosio::binary_extension<uint32_t> refcount;
+
+        uint64_t primary_key() const { return id; }
+        uint128_t get_user_and_poly_hash() const { return user_and_poly_hash(user.value, poly_id); }
+    };
+
+    typedef eosio::multi_index<"poly"_n, poly,
+        eosio::indexed_by<"byuserpoly"_n, eosio::const_mem_fun<poly, uint128_t, &poly::get_user_and_poly_hash>>>
+        poly_table;
+
+    struct deposit {
+        name owner;
+        asset balance;
+
+        uint64_t primary_key() const { return owner.value; }
+    };
+
+    typedef eosio::multi_index<"deposit"_n, deposit> deposit_table;
+
+    struct contract_state {
+        uint64_t next_persistent_id;
+    };
+
+    typedef eosio::singleton<"state"_n, contract_state> state_singleton;
+
+    struct land_migration {
+        uint64_t next_land_id;
+        bool done;
+    };
+
+    typedef eosio::singleton<"landmigrate"_n, land_migration> land_migration_singleton;
+
+} /// namespace infiniverse_rows
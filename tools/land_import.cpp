@@ -0,0 +1,139 @@
+#include "land_import.hpp"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "lat_long_functions.cpp"
+
+namespace land_import {
+
+    namespace {
+        const int64_t max_land_length_mm = 100 * 1000;
+
+        // A land of the sweep, from the set to import or already registered
+        struct swept_land {
+            int32_t lat_north_edge;
+            int32_t long_east_edge;
+            int32_t lat_south_edge;
+            int32_t long_west_edge;
+            bool registered;
+            // Position in the set, or land id when registered
+            uint64_t index;
+        };
+
+        std::string describe(const swept_land& land)
+        {
+            return land.registered ? "registered land " + std::to_string(land.index)
+                : "land " + std::to_string(land.index + 1);
+        }
+
+        // The same limits as assert_valid_land_bounds and assert_land_length in the contract
+        void check_land(const imported_land& land, size_t index)
+        {
+            std::string error;
+            if(land.lat_north_edge >= 85000000 || land.lat_south_edge <= -85000000)
+                error = "latitude must be between -85 and 85 degrees";
+            else if(land.long_east_edge > 180000000 || land.long_east_edge <= -180000000
+                || land.long_west_edge > 180000000 || land.long_west_edge <= -180000000)
+                error = "longitude must be between -180 and 180 degrees";
+            else if(land.lat_north_edge <= land.lat_south_edge)
+                error = "north edge must have greater latitude than south edge";
+            else if(land.long_east_edge <= land.long_west_edge)
+                error = "east edge must have greater longitude than west edge";
+            else
+            {
+                std::pair<int64_t, int64_t> land_size = lat_long_to_millimeters(land.lat_north_edge,
+                    land.lat_south_edge, land.long_east_edge, land.long_west_edge);
+                if(land_size.first > max_land_length_mm || land_size.second > max_land_length_mm)
+                    error = "land cannot exceed a length of 100 meters on either side";
+            }
+            if(!error.empty())
+            {
+                throw std::runtime_error("Land " + std::to_string(index + 1) + ": " + error);
+            }
+        }
+    }
+
+    std::vector<imported_land> parse_lands(std::istream& input)
+    {
+        std::vector<imported_land> lands;
+        size_t line_number = 0;
+        for(std::string line; std::getline(input, line);)
+        {
+            line_number++;
+            std::istringstream fields(line);
+            std::string owner;
+            if(!(fields >> owner) || owner[0] == '#')
+            {
+                continue;
+            }
+            imported_land land;
+            std::string trailing;
+            if(owner.size() > 12 || !(fields >> land.lat_north_edge >> land.long_east_edge >> land.lat_south_edge
+                >> land.long_west_edge) || fields >> trailing)
+            {
+                throw std::runtime_error("Line " + std::to_string(line_number)
+                    + " is not \"owner north east south west\"");
+            }
+            land.owner = eosio::name(owner);
+            lands.push_back(land);
+        }
+        return lands;
+    }
+
+    std::vector<std::vector<imported_land>> plan_import(const std::vector<imported_land>& lands,
+        const land_snapshot::snapshot_view* existing, size_t batch_size)
+    {
+        if(batch_size == 0)
+        {
+            throw std::runtime_error("Batches must hold at least one land");
+        }
+
+        std::vector<swept_land> swept;
+        swept.reserve(lands.size() + (existing ? existing->lands().size() : 0));
+        for(size_t i = 0; i < lands.size(); i++)
+        {
+            check_land(lands[i], i);
+            swept.push_back({lands[i].lat_north_edge, lands[i].long_east_edge, lands[i].lat_south_edge,
+                lands[i].long_west_edge, false, i});
+        }
+        if(existing)
+        {
+            for(const land_snapshot::land_record& land : existing->lands())
+            {
+                swept.push_back({land.lat_north_edge, land.long_east_edge, land.lat_south_edge, land.long_west_edge,
+                    true, land.id});
+            }
+        }
+
+        std::pair<const swept_land*, const swept_land*> overlap = find_intersecting_lands(swept);
+        if(overlap.first)
+        {
+            throw std::runtime_error("Lands intersect: " + describe(*overlap.first) + " and " + describe(*overlap.second));
+        }
+
+        std::vector<std::vector<imported_land>> batches;
+        for(size_t first = 0; first < lands.size(); first += batch_size)
+        {
+            batches.emplace_back(lands.begin() + first, lands.begin() + std::min(first + batch_size, lands.size()));
+        }
+        return batches;
+    }
+
+    std::string batch_json(const std::vector<imported_land>& batch)
+    {
+        std::ostringstream json;
+        json << "{\"imports\":[";
+        for(size_t i = 0; i < batch.size(); i++)
+        {
+            json << (i > 0 ? "," : "") << "{\"owner\":\"" << batch[i].owner.to_string()
+                << "\",\"lat_north_edge\":" << batch[i].lat_north_edge
+                << ",\"long_east_edge\":" << batch[i].long_east_edge
+                << ",\"lat_south_edge\":" << batch[i].lat_south_edge
+                << ",\"long_west_edge\":" << batch[i].long_west_edge << "}";
+        }
+        json << "]}";
+        return json.str();
+    }
+
+} /// namespace land_import
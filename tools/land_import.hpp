@@ -0,0 +1,37 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include <eosiolib/eosio.hpp>
+
+#include "land_snapshot.hpp"
+
+// Offline checks for importlands. The action only sweeps each batch for overlaps within itself, so the
+// whole set is checked here against itself and against a snapshot of the lands already registered.
+namespace land_import {
+
+    // Argument of importlands, edges in signed micro degrees
+    struct imported_land {
+        eosio::name owner;
+        int32_t lat_north_edge;
+        int32_t long_east_edge;
+        int32_t lat_south_edge;
+        int32_t long_west_edge;
+    };
+
+    // One land per line, "owner north east south west" with edges in micro degrees. Blank lines and
+    // lines starting with # are skipped
+    std::vector<imported_land> parse_lands(std::istream& input);
+
+    // Checks every land against the limits importlands enforces, then sweeps the set together with the
+    // snapshot's lands so none of them intersect, and splits the set into batches of at most batch_size in
+    // input order. Throws std::runtime_error naming the first invalid land by its position in the set
+    std::vector<std::vector<imported_land>> plan_import(const std::vector<imported_land>& lands,
+        const land_snapshot::snapshot_view* existing, size_t batch_size);
+
+    // Action data of one importlands call as JSON, for cleos push action
+    std::string batch_json(const std::vector<imported_land>& batch);
+
+} /// namespace land_import
@@ -0,0 +1,334 @@
+#include "land_rtree.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iterator>
+
+namespace land_rtree {
+
+    namespace {
+        const land_box empty_box{INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX};
+
+        land_box box_union(const land_box& a, const land_box& b)
+        {
+            return {std::max(a.lat_north_edge, b.lat_north_edge), std::max(a.long_east_edge, b.long_east_edge),
+                std::min(a.lat_south_edge, b.lat_south_edge), std::min(a.long_west_edge, b.long_west_edge)};
+        }
+
+        int64_t box_area(const land_box& box)
+        {
+            return ((int64_t)box.lat_north_edge - box.lat_south_edge) * ((int64_t)box.long_east_edge - box.long_west_edge);
+        }
+
+        // Touching edges do not intersect, as in lands_intersect
+        bool boxes_intersect(const land_box& a, const land_box& b)
+        {
+            return a.long_east_edge > b.long_west_edge && a.long_west_edge < b.long_east_edge &&
+                a.lat_north_edge > b.lat_south_edge && a.lat_south_edge < b.lat_north_edge;
+        }
+
+        bool box_covers(const land_box& outer, const land_box& inner)
+        {
+            return outer.lat_north_edge >= inner.lat_north_edge && outer.long_east_edge >= inner.long_east_edge &&
+                outer.lat_south_edge <= inner.lat_south_edge && outer.long_west_edge <= inner.long_west_edge;
+        }
+
+        bool box_contains_point(const land_box& box, int32_t lat, int32_t lng)
+        {
+            return lat >= box.lat_south_edge && lat < box.lat_north_edge &&
+                lng >= box.long_west_edge && lng < box.long_east_edge;
+        }
+
+        // Doubled centers, so they stay integers
+        int64_t center_long(const land_box& box)
+        {
+            return (int64_t)box.long_west_edge + box.long_east_edge;
+        }
+
+        int64_t center_lat(const land_box& box)
+        {
+            return (int64_t)box.lat_south_edge + box.lat_north_edge;
+        }
+
+        // Sort-Tile-Recursive packing of one level into groups of at most max_entries
+        template<typename T, typename BoxOf>
+        std::vector<std::vector<T>> tile(std::vector<T> items, BoxOf box_of)
+        {
+            size_t group_count = (items.size() + rtree::max_entries - 1) / rtree::max_entries;
+            size_t slice_count = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(group_count))));
+            size_t slice_size = slice_count * rtree::max_entries;
+
+            std::sort(items.begin(), items.end(),
+                [&](const T& a, const T& b) { return center_long(box_of(a)) < center_long(box_of(b)); });
+            std::vector<std::vector<T>> groups;
+            for(size_t slice = 0; slice < items.size(); slice += slice_size)
+            {
+                auto slice_end = items.begin() + std::min(slice + slice_size, items.size());
+                std::sort(items.begin() + slice, slice_end,
+                    [&](const T& a, const T& b) { return center_lat(box_of(a)) < center_lat(box_of(b)); });
+                for(auto group_itr = items.begin() + slice; group_itr != slice_end;)
+                {
+                    auto group_end = group_itr + std::min<ptrdiff_t>(rtree::max_entries, slice_end - group_itr);
+                    groups.emplace_back(std::make_move_iterator(group_itr), std::make_move_iterator(group_end));
+                    group_itr = group_end;
+                }
+            }
+            return groups;
+        }
+    }
+
+    // Leaves are level 0 and hold entries, inner nodes hold the nodes one level down
+    struct rtree::node {
+        land_box box = empty_box;
+        size_t level = 0;
+        std::vector<land_entry> entries;
+        std::vector<std::unique_ptr<node>> children;
+
+        size_t count() const { return level == 0 ? entries.size() : children.size(); }
+
+        void update_box()
+        {
+            box = empty_box;
+            for(const land_entry& entry : entries)
+                box = box_union(box, entry.box);
+            for(const std::unique_ptr<node>& child : children)
+                box = box_union(box, child->box);
+        }
+
+        void collect_entries(std::vector<land_entry>& collected) const
+        {
+            collected.insert(collected.end(), entries.begin(), entries.end());
+            for(const std::unique_ptr<node>& child : children)
+                child->collect_entries(collected);
+        }
+    };
+
+    rtree::rtree() : root(new node()) {}
+
+    rtree::~rtree() = default;
+
+    void rtree::bulk_load(std::vector<land_entry> entries)
+    {
+        entry_count = entries.size();
+        root.reset(new node());
+        if(entries.empty())
+        {
+            return;
+        }
+
+        std::vector<std::unique_ptr<node>> level_nodes;
+        for(std::vector<land_entry>& group : tile(std::move(entries), [](const land_entry& entry) { return entry.box; }))
+        {
+            std::unique_ptr<node> leaf(new node());
+            leaf->entries = std::move(group);
+            leaf->update_box();
+            level_nodes.push_back(std::move(leaf));
+        }
+        for(size_t level = 1; level_nodes.size() > 1; level++)
+        {
+            std::vector<std::unique_ptr<node>> parents;
+            for(std::vector<std::unique_ptr<node>>& group :
+                tile(std::move(level_nodes), [](const std::unique_ptr<node>& child) { return child->box; }))
+            {
+                std::unique_ptr<node> parent(new node());
+                parent->level = level;
+                parent->children = std::move(group);
+                parent->update_box();
+                parents.push_back(std::move(parent));
+            }
+            level_nodes = std::move(parents);
+        }
+        root = std::move(level_nodes.front());
+    }
+
+    void rtree::insert(const land_entry& entry)
+    {
+        std::unique_ptr<node> sibling = insert_into(*root, entry);
+        if(sibling)
+        {
+            std::unique_ptr<node> new_root(new node());
+            new_root->level = root->level + 1;
+            new_root->children.push_back(std::move(root));
+            new_root->children.push_back(std::move(sibling));
+            new_root->update_box();
+            root = std::move(new_root);
+        }
+        entry_count++;
+    }
+
+    bool rtree::erase(uint64_t id, const land_box& box)
+    {
+        std::vector<land_entry> orphans;
+        if(!erase_from(*root, id, box, orphans))
+        {
+            return false;
+        }
+        entry_count -= 1 + orphans.size();
+        while(root->level > 0 && root->children.size() == 1)
+        {
+            root = std::move(root->children.front());
+        }
+        if(root->count() == 0)
+        {
+            root.reset(new node());
+        }
+        for(const land_entry& orphan : orphans)
+        {
+            insert(orphan);
+        }
+        return true;
+    }
+
+    std::vector<uint64_t> rtree::query(const land_box& viewport) const
+    {
+        std::vector<uint64_t> ids;
+        query_node(*root, viewport, ids);
+        return ids;
+    }
+
+    const land_entry* rtree::find_at(int32_t lat, int32_t lng) const
+    {
+        return find_in_node(*root, lat, lng);
+    }
+
+    size_t rtree::height() const
+    {
+        return root->level + 1;
+    }
+
+    std::unique_ptr<rtree::node> rtree::insert_into(node& current, const land_entry& entry)
+    {
+        if(current.level == 0)
+        {
+            current.entries.push_back(entry);
+        }
+        else
+        {
+            // The child growing least, then the smallest one
+            node* chosen = nullptr;
+            int64_t chosen_growth = 0;
+            for(const std::unique_ptr<node>& child : current.children)
+            {
+                int64_t growth = box_area(box_union(child->box, entry.box)) - box_area(child->box);
+                if(!chosen || growth < chosen_growth
+                    || (growth == chosen_growth && box_area(child->box) < box_area(chosen->box)))
+                {
+                    chosen = child.get();
+                    chosen_growth = growth;
+                }
+            }
+            std::unique_ptr<node> sibling = insert_into(*chosen, entry);
+            if(sibling)
+            {
+                current.children.push_back(std::move(sibling));
+            }
+        }
+        current.update_box();
+        return current.count() > max_entries ? split(current) : nullptr;
+    }
+
+    // Halves the node along the axis its centers spread furthest on
+    std::unique_ptr<rtree::node> rtree::split(node& current)
+    {
+        std::unique_ptr<node> sibling(new node());
+        sibling->level = current.level;
+
+        auto split_items = [](auto& items, auto& split_off, auto box_of) {
+            int64_t min_long = INT64_MAX, max_long = INT64_MIN, min_lat = INT64_MAX, max_lat = INT64_MIN;
+            for(const auto& item : items)
+            {
+                min_long = std::min(min_long, center_long(box_of(item)));
+                max_long = std::max(max_long, center_long(box_of(item)));
+                min_lat = std::min(min_lat, center_lat(box_of(item)));
+                max_lat = std::max(max_lat, center_lat(box_of(item)));
+            }
+            bool by_long = max_long - min_long >= max_lat - min_lat;
+            std::sort(items.begin(), items.end(), [&](const auto& a, const auto& b) {
+                return by_long ? center_long(box_of(a)) < center_long(box_of(b))
+                    : center_lat(box_of(a)) < center_lat(box_of(b));
+            });
+            auto half = items.begin() + items.size() / 2;
+            std::move(half, items.end(), std::back_inserter(split_off));
+            items.erase(half, items.end());
+        };
+        if(current.level == 0)
+        {
+            split_items(current.entries, sibling->entries, [](const land_entry& entry) { return entry.box; });
+        }
+        else
+        {
+            split_items(current.children, sibling->children, [](const std::unique_ptr<node>& child) { return child->box; });
+        }
+        current.update_box();
+        sibling->update_box();
+        return sibling;
+    }
+
+    bool rtree::erase_from(node& current, uint64_t id, const land_box& box, std::vector<land_entry>& orphans)
+    {
+        if(current.level == 0)
+        {
+            auto entry_itr = std::find_if(current.entries.begin(), current.entries.end(), [&](const land_entry& entry) {
+                return entry.id == id && entry.box.lat_north_edge == box.lat_north_edge
+                    && entry.box.long_east_edge == box.long_east_edge && entry.box.lat_south_edge == box.lat_south_edge
+                    && entry.box.long_west_edge == box.long_west_edge;
+            });
+            if(entry_itr == current.entries.end())
+            {
+                return false;
+            }
+            current.entries.erase(entry_itr);
+            current.update_box();
+            return true;
+        }
+        for(auto child_itr = current.children.begin(); child_itr != current.children.end(); child_itr++)
+        {
+            if(box_covers((*child_itr)->box, box) && erase_from(**child_itr, id, box, orphans))
+            {
+                if((*child_itr)->count() < min_entries)
+                {
+                    (*child_itr)->collect_entries(orphans);
+                    current.children.erase(child_itr);
+                }
+                current.update_box();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void rtree::query_node(const node& current, const land_box& viewport, std::vector<uint64_t>& ids)
+    {
+        for(const land_entry& entry : current.entries)
+        {
+            if(boxes_intersect(entry.box, viewport))
+                ids.push_back(entry.id);
+        }
+        for(const std::unique_ptr<node>& child : current.children)
+        {
+            if(boxes_intersect(child->box, viewport))
+                query_node(*child, viewport, ids);
+        }
+    }
+
+    const land_entry* rtree::find_in_node(const node& current, int32_t lat, int32_t lng)
+    {
+        for(const land_entry& entry : current.entries)
+        {
+            if(box_contains_point(entry.box, lat, lng))
+                return &entry;
+        }
+        for(const std::unique_ptr<node>& child : current.children)
+        {
+            if(box_contains_point(child->box, lat, lng))
+            {
+                const land_entry* found = find_in_node(*child, lat, lng);
+                if(found)
+                    return found;
+            }
+        }
+        return nullptr;
+    }
+
+} /// namespace land_rtree
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// In-memory R-tree of land rectangles for clients and indexers that hold a copy of the land table,
+// for example one loaded from a snapshot. Edges are signed micro degrees, as in the land table.
+namespace land_rtree {
+
+    struct land_box {
+        int32_t lat_north_edge;
+        int32_t long_east_edge;
+        int32_t lat_south_edge;
+        int32_t long_west_edge;
+    };
+
+    struct land_entry {
+        uint64_t id;
+        land_box box;
+    };
+
+    // Entries of any rows with the land table's id and edges, such as land rows or snapshot records
+    template<typename Rows>
+    std::vector<land_entry> land_entries(const Rows& rows)
+    {
+        std::vector<land_entry> entries;
+        for(const auto& row : rows)
+        {
+            entries.push_back({row.id, {row.lat_north_edge, row.long_east_edge, row.lat_south_edge, row.long_west_edge}});
+        }
+        return entries;
+    }
+
+    class rtree {
+        public:
+            static const size_t max_entries = 16;
+            static const size_t min_entries = max_entries / 4;
+
+            rtree();
+            ~rtree();
+
+            // Replaces the contents with a tree packed by Sort-Tile-Recursive: entries are sorted into
+            // vertical slices by longitude and each slice into nodes by latitude, level by level
+            void bulk_load(std::vector<land_entry> entries);
+
+            void insert(const land_entry& entry);
+            // Removes the entry with the given id and box, false if there is none
+            bool erase(uint64_t id, const land_box& box);
+
+            // Lands intersecting the viewport, touching edges do not intersect like in the contract
+            std::vector<uint64_t> query(const land_box& viewport) const;
+            // The land covering a point, its south and west edges included, or nullptr
+            const land_entry* find_at(int32_t lat, int32_t lng) const;
+
+            size_t size() const { return entry_count; }
+            size_t height() const;
+
+        private:
+            struct node;
+
+            // Each returns the node split off the given one when it overflows
+            static std::unique_ptr<node> insert_into(node& current, const land_entry& entry);
+            static std::unique_ptr<node> split(node& current);
+            // Nodes left with too few entries are dropped and their entries reinserted
+            static bool erase_from(node& current, uint64_t id, const land_box& box, std::vector<land_entry>& orphans);
+            static void query_node(const node& current, const land_box& viewport, std::vector<uint64_t>& ids);
+            static const land_entry* find_in_node(const node& current, int32_t lat, int32_t lng);
+
+            std::unique_ptr<node> root;
+            size_t entry_count = 0;
+    };
+
+} /// namespace land_rtree
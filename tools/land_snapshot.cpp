@@ -0,0 +1,160 @@
+#include "land_snapshot.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace land_snapshot {
+
+    namespace {
+        uint64_t align_to_record(uint64_t offset)
+        {
+            return (offset + 7) & ~uint64_t(7);
+        }
+
+        void check_section(uint64_t offset, uint64_t count, size_t record_size, size_t file_size, const char* section)
+        {
+            if(offset % 8 != 0 || offset > file_size || count > (file_size - offset) / record_size)
+            {
+                throw std::runtime_error(std::string("Snapshot ") + section + " records are out of bounds");
+            }
+        }
+
+        template<typename T>
+        void write_records(std::FILE* file, const std::vector<T>& records, uint64_t offset)
+        {
+            if(std::fseek(file, static_cast<long>(offset), SEEK_SET) != 0
+                || std::fwrite(records.data(), sizeof(T), records.size(), file) != records.size())
+            {
+                throw std::runtime_error("Could not write snapshot records");
+            }
+        }
+    }
+
+    snapshot_view::snapshot_view(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            throw std::runtime_error("Could not open snapshot " + path);
+        }
+        struct stat file_stat;
+        if(::fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(snapshot_header))
+        {
+            ::close(fd);
+            throw std::runtime_error("Snapshot " + path + " is too small to hold a header");
+        }
+        size = static_cast<size_t>(file_stat.st_size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map snapshot " + path);
+        }
+        data = static_cast<const char*>(mapped);
+
+        const snapshot_header& file_header = header();
+        try
+        {
+            if(std::memcmp(file_header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0)
+                throw std::runtime_error("Not a land snapshot: " + path);
+            if(file_header.byte_order != snapshot_byte_order)
+                throw std::runtime_error("Snapshot " + path + " was written with another byte order");
+            if(file_header.version != snapshot_version)
+                throw std::runtime_error("Snapshot " + path + " has unsupported version " + std::to_string(file_header.version));
+            check_section(file_header.land_offset, file_header.land_count, sizeof(land_record), size, "land");
+            check_section(file_header.persistent_offset, file_header.persistent_count, sizeof(persistent_record), size,
+                "persistent");
+            check_section(file_header.poly_offset, file_header.poly_count, sizeof(poly_record), size, "poly");
+            check_section(file_header.deposit_offset, file_header.deposit_count, sizeof(deposit_record), size, "deposit");
+        }
+        catch(...)
+        {
+            ::munmap(const_cast<char*>(data), size);
+            throw;
+        }
+    }
+
+    snapshot_view::~snapshot_view()
+    {
+        ::munmap(const_cast<char*>(data), size);
+    }
+
+    const land_record* snapshot_view::find_land(uint64_t id) const
+    {
+        record_range<land_record> all = lands();
+        const land_record* found = std::lower_bound(all.begin(), all.end(), id,
+            [](const land_record& record, uint64_t land_id) { return record.id < land_id; });
+        return found != all.end() && found->id == id ? found : nullptr;
+    }
+
+    record_range<persistent_record> snapshot_view::persistents_of(uint64_t land_id) const
+    {
+        record_range<persistent_record> all = persistents();
+        const persistent_record* first = std::lower_bound(all.begin(), all.end(), land_id,
+            [](const persistent_record& record, uint64_t id) { return record.land_id < id; });
+        const persistent_record* last = std::upper_bound(first, all.end(), land_id,
+            [](uint64_t id, const persistent_record& record) { return id < record.land_id; });
+        return {first, static_cast<size_t>(last - first)};
+    }
+
+    void write_snapshot(const std::string& path, snapshot_tables tables)
+    {
+        std::sort(tables.lands.begin(), tables.lands.end(),
+            [](const land_record& a, const land_record& b) { return a.id < b.id; });
+        std::sort(tables.persistents.begin(), tables.persistents.end(),
+            [](const persistent_record& a, const persistent_record& b) {
+                return a.land_id != b.land_id ? a.land_id < b.land_id : a.id < b.id;
+            });
+        std::sort(tables.polys.begin(), tables.polys.end(),
+            [](const poly_record& a, const poly_record& b) { return a.id < b.id; });
+        std::sort(tables.deposits.begin(), tables.deposits.end(),
+            [](const deposit_record& a, const deposit_record& b) { return a.owner < b.owner; });
+
+        snapshot_header file_header{};
+        std::memcpy(file_header.magic, snapshot_magic, sizeof(snapshot_magic));
+        file_header.version = snapshot_version;
+        file_header.byte_order = snapshot_byte_order;
+        file_header.next_persistent_id = tables.next_persistent_id;
+        file_header.land_count = tables.lands.size();
+        file_header.land_offset = align_to_record(sizeof(snapshot_header));
+        file_header.persistent_count = tables.persistents.size();
+        file_header.persistent_offset = align_to_record(file_header.land_offset + tables.lands.size() * sizeof(land_record));
+        file_header.poly_count = tables.polys.size();
+        file_header.poly_offset = align_to_record(file_header.persistent_offset
+            + tables.persistents.size() * sizeof(persistent_record));
+        file_header.deposit_count = tables.deposits.size();
+        file_header.deposit_offset = align_to_record(file_header.poly_offset + tables.polys.size() * sizeof(poly_record));
+
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if(!file)
+        {
+            throw std::runtime_error("Could not create snapshot " + path);
+        }
+        try
+        {
+            if(std::fwrite(&file_header, sizeof(file_header), 1, file) != 1)
+                throw std::runtime_error("Could not write snapshot header");
+            write_records(file, tables.lands, file_header.land_offset);
+            write_records(file, tables.persistents, file_header.persistent_offset);
+            write_records(file, tables.polys, file_header.poly_offset);
+            write_records(file, tables.deposits, file_header.deposit_offset);
+        }
+        catch(...)
+        {
+            std::fclose(file);
+            throw;
+        }
+        if(std::fclose(file) != 0)
+        {
+            throw std::runtime_error("Could not write snapshot " + path);
+        }
+    }
+
+} /// namespace land_snapshot
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "transform_encoding.hpp"
+
+// Snapshot of the land, persistent, poly and deposit tables in a versioned file of fixed size records.
+// Every record is plain data at an 8 byte aligned offset, so a memory mapped file is read in place
+// without parsing. Names are stored as their uint64 values and edges as signed micro degrees.
+//
+// File layout, little endian:
+//   snapshot_header
+//   land_record[land_count]              sorted by id
+//   persistent_record[persistent_count]  sorted by land_id then id, so a land's scene is one run
+//   poly_record[poly_count]              sorted by id
+//   deposit_record[deposit_count]        sorted by owner
+namespace land_snapshot {
+
+    const char snapshot_magic[8] = {'I', 'N', 'F', 'S', 'N', 'A', 'P', '\0'};
+    const uint32_t snapshot_version = 1;
+    // Stored as written, so a file from a host of the other byte order is recognized and rejected
+    const uint32_t snapshot_byte_order = 0x01020304;
+
+    struct snapshot_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        // Next id the contract hands out, persistent ids are unique across land scopes
+        uint64_t next_persistent_id;
+        uint64_t land_count;
+        uint64_t land_offset;
+        uint64_t persistent_count;
+        uint64_t persistent_offset;
+        uint64_t poly_count;
+        uint64_t poly_offset;
+        uint64_t deposit_count;
+        uint64_t deposit_offset;
+    };
+
+    // Payers are kept so a loaded table bills RAM to the same accounts
+    struct land_record {
+        uint64_t id;
+        uint64_t owner;
+        uint64_t payer;
+        int32_t lat_north_edge;
+        int32_t long_east_edge;
+        int32_t lat_south_edge;
+        int32_t long_west_edge;
+        uint32_t reg_end_date;
+        uint32_t reserved;
+    };
+
+    struct persistent_record {
+        uint64_t id;
+        uint64_t land_id;
+        uint64_t payer;
+        uint64_t source;
+        uint64_t asset_id;
+        compact_transform transform;
+    };
+
+    struct poly_record {
+        uint64_t id;
+        uint64_t user;
+        uint64_t payer;
+        uint32_t refcount;
+        // Poly ids are 11 characters, padded with zeros
+        char poly_id[12];
+    };
+
+    // Deposits are always paid by their owner
+    struct deposit_record {
+        uint64_t owner;
+        int64_t amount;
+        uint64_t symbol;
+    };
+
+    static_assert(sizeof(snapshot_header) == 88, "snapshot_header layout changed");
+    static_assert(sizeof(land_record) == 48, "land_record layout changed");
+    static_assert(sizeof(persistent_record) == 56, "persistent_record layout changed");
+    static_assert(sizeof(poly_record) == 40, "poly_record layout changed");
+    static_assert(sizeof(deposit_record) == 24, "deposit_record layout changed");
+    static_assert(std::is_trivially_copyable<land_record>::value && std::is_trivially_copyable<persistent_record>::value
+        && std::is_trivially_copyable<poly_record>::value && std::is_trivially_copyable<deposit_record>::value,
+        "records must be plain data to be read in place");
+
+    template<typename T>
+    struct record_range {
+        const T* first = nullptr;
+        size_t count = 0;
+
+        const T* begin() const { return first; }
+        const T* end() const { return first + count; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const T& operator[](size_t i) const { return first[i]; }
+    };
+
+    // Maps a snapshot file read only and checks its header and bounds, the records are read in place.
+    // Throws std::runtime_error when the file can't be mapped or is not a valid snapshot
+    class snapshot_view {
+        public:
+            explicit snapshot_view(const std::string& path);
+            ~snapshot_view();
+
+            snapshot_view(const snapshot_view&) = delete;
+            snapshot_view& operator=(const snapshot_view&) = delete;
+
+            const snapshot_header& header() const { return *reinterpret_cast<const snapshot_header*>(data); }
+
+            record_range<land_record> lands() const { return range<land_record>(header().land_offset, header().land_count); }
+            record_range<persistent_record> persistents() const
+            {
+                return range<persistent_record>(header().persistent_offset, header().persistent_count);
+            }
+            record_range<poly_record> polys() const { return range<poly_record>(header().poly_offset, header().poly_count); }
+            record_range<deposit_record> deposits() const
+            {
+                return range<deposit_record>(header().deposit_offset, header().deposit_count);
+            }
+
+            // Binary searches of the sorted records
+            const land_record* find_land(uint64_t id) const;
+            record_range<persistent_record> persistents_of(uint64_t land_id) const;
+
+        private:
+            template<typename T>
+            record_range<T> range(uint64_t offset, uint64_t count) const
+            {
+                return {reinterpret_cast<const T*>(data + offset), static_cast<size_t>(count)};
+            }
+
+            const char* data = nullptr;
+            size_t size = 0;
+    };
+
+    struct snapshot_tables {
+        uint64_t next_persistent_id = 0;
+        std::vector<land_record> lands;
+        std::vector<persistent_record> persistents;
+        std::vector<poly_record> polys;
+        std::vector<deposit_record> deposits;
+    };
+
+    // Sorts the records into file order and writes the snapshot, throws std::runtime_error on failure
+    void write_snapshot(const std::string& path, snapshot_tables tables);
+
+} /// namespace land_snapshot
@@ -0,0 +1,71 @@
+#include "snapshot_rows.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// land_snapshot info SNAPSHOT          prints the header and record counts
+// land_snapshot dump SNAPSHOT          prints every row in the text form of snapshot_rows.hpp
+// land_snapshot build ROWS SNAPSHOT    writes a snapshot from rows in that text form
+//
+// Rows come from a table dump of the contract, for example the packed rows of get_table_rows,
+// one "<table> <scope> <payer> <hex>" line each.
+int usage()
+{
+    std::fprintf(stderr, "usage: land_snapshot info SNAPSHOT | dump SNAPSHOT | build ROWS SNAPSHOT\n");
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        return usage();
+    }
+    std::string command = argv[1];
+    try
+    {
+        if(command == "info" && argc == 3)
+        {
+            land_snapshot::snapshot_view snapshot(argv[2]);
+            const land_snapshot::snapshot_header& header = snapshot.header();
+            std::printf("version %u\nnext_persistent_id %llu\nlands %llu\npersistents %llu\npolys %llu\ndeposits %llu\n",
+                header.version, (unsigned long long) header.next_persistent_id, (unsigned long long) header.land_count,
+                (unsigned long long) header.persistent_count, (unsigned long long) header.poly_count,
+                (unsigned long long) header.deposit_count);
+        }
+        else if(command == "dump" && argc == 3)
+        {
+            land_snapshot::snapshot_view snapshot(argv[2]);
+            for(const std::string& line : land_snapshot::dump_rows(snapshot))
+            {
+                std::cout << line << '\n';
+            }
+        }
+        else if(command == "build" && argc == 4)
+        {
+            std::ifstream input(argv[2]);
+            if(!input)
+            {
+                throw std::runtime_error(std::string("Could not open ") + argv[2]);
+            }
+            std::vector<std::string> lines;
+            for(std::string line; std::getline(input, line);)
+            {
+                lines.push_back(line);
+            }
+            land_snapshot::write_snapshot(argv[3], land_snapshot::parse_rows(lines));
+        }
+        else
+        {
+            return usage();
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::fprintf(stderr, "land_snapshot: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
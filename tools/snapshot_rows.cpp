@@ -0,0 +1,310 @@
+#include "snapshot_rows.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace land_snapshot {
+
+    using eosio::name;
+
+    namespace {
+        const char hex_digits[] = "0123456789abcdef";
+
+        std::string to_hex(const std::vector<char>& bytes)
+        {
+            std::string hex;
+            hex.reserve(bytes.size() * 2);
+            for(char byte : bytes)
+            {
+                hex += hex_digits[(byte >> 4) & 0xf];
+                hex += hex_digits[byte & 0xf];
+            }
+            return hex;
+        }
+
+        int hex_value(char digit)
+        {
+            const char* found = std::strchr(hex_digits, digit);
+            if(digit == '\0' || !found)
+            {
+                throw std::runtime_error(std::string("Invalid hex digit ") + digit);
+            }
+            return static_cast<int>(found - hex_digits);
+        }
+
+        std::vector<char> from_hex(const std::string& hex)
+        {
+            if(hex.size() % 2 != 0)
+            {
+                throw std::runtime_error("Packed row has an odd number of hex digits");
+            }
+            std::vector<char> bytes(hex.size() / 2);
+            for(size_t i = 0; i < bytes.size(); i++)
+            {
+                bytes[i] = static_cast<char>(hex_value(hex[2 * i]) << 4 | hex_value(hex[2 * i + 1]));
+            }
+            return bytes;
+        }
+
+        template<typename T>
+        std::string row_line(const char* table, uint64_t scope, name payer, const T& row)
+        {
+            std::ostringstream line;
+            line << table << ' ' << scope << ' ' << payer.to_string() << ' ' << to_hex(eosio::pack(row));
+            return line.str();
+        }
+
+        // Every row is billed to its recorded payer, who has to authorize it in the harness
+        template<typename Table, typename Row>
+        void emplace_as(Table& table, name payer, const Row& row)
+        {
+            eosio::host::authorizations.assign(1, payer);
+            table.emplace(payer, [&](Row& stored) { stored = row; });
+        }
+    }
+
+    land_record to_record(const infiniverse_rows::land& row, name payer)
+    {
+        land_record record{};
+        record.id = row.id;
+        record.owner = row.owner.value;
+        record.payer = payer.value;
+        record.lat_north_edge = row.lat_north_edge;
+        record.long_east_edge = row.long_east_edge;
+        record.lat_south_edge = row.lat_south_edge;
+        record.long_west_edge = row.long_west_edge;
+        record.reg_end_date = row.reg_end_date.utc_seconds;
+        return record;
+    }
+
+    persistent_record to_record(const infiniverse_rows::persistent& row, name payer)
+    {
+        persistent_record record{};
+        record.id = row.id;
+        record.land_id = row.land_id;
+        record.payer = payer.value;
+        record.source = static_cast<uint64_t>(row.source_and_asset_id >> 64);
+        record.asset_id = static_cast<uint64_t>(row.source_and_asset_id);
+        record.transform = row.transform;
+        return record;
+    }
+
+    poly_record to_record(const infiniverse_rows::poly& row, name payer)
+    {
+        if(!row.refcount.has_value())
+        {
+            throw std::runtime_error("Poly " + std::to_string(row.id) + " has no refcount, run migratepers first");
+        }
+        if(row.poly_id.size() >= sizeof(poly_record::poly_id))
+        {
+            throw std::runtime_error("Poly " + std::to_string(row.id) + " has an id longer than 11 characters");
+        }
+        poly_record record{};
+        record.id = row.id;
+        record.user = row.user.value;
+        record.payer = payer.value;
+        record.refcount = row.refcount.value();
+        std::memcpy(record.poly_id, row.poly_id.data(), row.poly_id.size());
+        return record;
+    }
+
+    deposit_record to_record(const infiniverse_rows::deposit& row)
+    {
+        return {row.owner.value, row.balance.amount, row.balance.symbol.raw()};
+    }
+
+    infiniverse_rows::land to_row(const land_record& record)
+    {
+        return {record.id, name(record.owner), record.lat_north_edge, record.long_east_edge, record.lat_south_edge,
+            record.long_west_edge, eosio::time_point_sec(record.reg_end_date)};
+    }
+
+    infiniverse_rows::persistent to_row(const persistent_record& record)
+    {
+        return {record.id, record.land_id, (uint128_t) record.source << 64 | record.asset_id, record.transform};
+    }
+
+    infiniverse_rows::poly to_row(const poly_record& record)
+    {
+        return {record.id, name(record.user), std::string(record.poly_id, strnlen(record.poly_id, sizeof(record.poly_id))),
+            record.refcount};
+    }
+
+    infiniverse_rows::deposit to_row(const deposit_record& record)
+    {
+        return {name(record.owner), eosio::asset(record.amount, eosio::symbol(record.symbol))};
+    }
+
+    snapshot_tables export_host_tables(name contract)
+    {
+        infiniverse_rows::land_migration_singleton land_migration(contract, contract.value);
+        if(eosio::host::row_count(contract, contract.value, "land"_n) > 0
+            && !land_migration.get_or_default({0, false}).done)
+        {
+            throw std::runtime_error("Lands must be migrated before taking a snapshot");
+        }
+
+        snapshot_tables tables;
+        infiniverse_rows::state_singleton state(contract, contract.value);
+        tables.next_persistent_id = state.get_or_default({0}).next_persistent_id;
+        for(const auto& [key, table] : eosio::host::tables())
+        {
+            const auto& [code, scope, table_name] = key;
+            if(code != contract.value)
+            {
+                continue;
+            }
+            for(const auto& [id, stored] : table.rows)
+            {
+                if(table_name == "land"_n.value && scope == contract.value)
+                {
+                    tables.lands.push_back(to_record(eosio::unpack<infiniverse_rows::land>(stored.data), stored.payer));
+                }
+                else if(table_name == "persistent"_n.value && scope != contract.value)
+                {
+                    tables.persistents.push_back(
+                        to_record(eosio::unpack<infiniverse_rows::persistent>(stored.data), stored.payer));
+                    tables.next_persistent_id = std::max(tables.next_persistent_id, id + 1);
+                }
+                else if(table_name == "persistent"_n.value)
+                {
+                    throw std::runtime_error("Persistents must be migrated before taking a snapshot");
+                }
+                else if(table_name == "poly"_n.value && scope == contract.value)
+                {
+                    tables.polys.push_back(to_record(eosio::unpack<infiniverse_rows::poly>(stored.data), stored.payer));
+                }
+                else if(table_name == "deposit"_n.value && scope == contract.value)
+                {
+                    tables.deposits.push_back(to_record(eosio::unpack<infiniverse_rows::deposit>(stored.data)));
+                }
+            }
+        }
+        return tables;
+    }
+
+    void load_host_tables(name contract, const snapshot_view& snapshot)
+    {
+        for(name table_name : {"land"_n, "poly"_n, "deposit"_n})
+        {
+            if(eosio::host::row_count(contract, contract.value, table_name) > 0)
+            {
+                throw std::runtime_error("Snapshots load into empty tables, " + table_name.to_string() + " has rows");
+            }
+        }
+
+        std::vector<name> authorizations = eosio::host::authorizations;
+        {
+            infiniverse_rows::land_table lands(contract, contract.value);
+            for(const land_record& record : snapshot.lands())
+            {
+                emplace_as(lands, name(record.payer), to_row(record));
+            }
+
+            // Persistents are sorted by land, so each land's scope is opened once
+            const persistent_record* scene = snapshot.persistents().begin();
+            while(scene != snapshot.persistents().end())
+            {
+                infiniverse_rows::persistent_table persistents(contract, scene->land_id);
+                uint64_t land_id = scene->land_id;
+                for(; scene != snapshot.persistents().end() && scene->land_id == land_id; scene++)
+                {
+                    emplace_as(persistents, name(scene->payer), to_row(*scene));
+                }
+            }
+
+            infiniverse_rows::poly_table polys(contract, contract.value);
+            for(const poly_record& record : snapshot.polys())
+            {
+                emplace_as(polys, name(record.payer), to_row(record));
+            }
+
+            infiniverse_rows::deposit_table deposits(contract, contract.value);
+            for(const deposit_record& record : snapshot.deposits())
+            {
+                emplace_as(deposits, name(record.owner), to_row(record));
+            }
+        }
+        eosio::host::authorizations = authorizations;
+
+        infiniverse_rows::state_singleton(contract, contract.value).set({snapshot.header().next_persistent_id}, contract);
+        infiniverse_rows::land_migration_singleton(contract, contract.value).set({0, true}, contract);
+    }
+
+    std::vector<std::string> dump_rows(const snapshot_view& snapshot)
+    {
+        std::vector<std::string> lines;
+        lines.push_back("next_persistent_id " + std::to_string(snapshot.header().next_persistent_id));
+        for(const land_record& record : snapshot.lands())
+        {
+            lines.push_back(row_line("land", 0, name(record.payer), to_row(record)));
+        }
+        for(const persistent_record& record : snapshot.persistents())
+        {
+            lines.push_back(row_line("persistent", record.land_id, name(record.payer), to_row(record)));
+        }
+        for(const poly_record& record : snapshot.polys())
+        {
+            lines.push_back(row_line("poly", 0, name(record.payer), to_row(record)));
+        }
+        for(const deposit_record& record : snapshot.deposits())
+        {
+            lines.push_back(row_line("deposit", 0, name(record.owner), to_row(record)));
+        }
+        return lines;
+    }
+
+    snapshot_tables parse_rows(const std::vector<std::string>& lines)
+    {
+        snapshot_tables tables;
+        for(const std::string& line : lines)
+        {
+            std::istringstream fields(line);
+            std::string table;
+            if(!(fields >> table))
+            {
+                continue;
+            }
+            if(table == "next_persistent_id")
+            {
+                if(!(fields >> tables.next_persistent_id))
+                    throw std::runtime_error("Invalid row: " + line);
+                continue;
+            }
+
+            uint64_t scope;
+            std::string payer, hex;
+            if(!(fields >> scope >> payer >> hex))
+            {
+                throw std::runtime_error("Invalid row: " + line);
+            }
+            std::vector<char> packed = from_hex(hex);
+            if(table == "land")
+            {
+                tables.lands.push_back(to_record(eosio::unpack<infiniverse_rows::land>(packed), name(payer)));
+            }
+            else if(table == "persistent")
+            {
+                persistent_record record = to_record(eosio::unpack<infiniverse_rows::persistent>(packed), name(payer));
+                if(record.land_id != scope)
+                    throw std::runtime_error("Persistent " + std::to_string(record.id) + " is not scoped by its land");
+                tables.persistents.push_back(record);
+            }
+            else if(table == "poly")
+            {
+                tables.polys.push_back(to_record(eosio::unpack<infiniverse_rows::poly>(packed), name(payer)));
+            }
+            else if(table == "deposit")
+            {
+                tables.deposits.push_back(to_record(eosio::unpack<infiniverse_rows::deposit>(packed)));
+            }
+            else
+            {
+                throw std::runtime_error("Unknown table " + table);
+            }
+        }
+        return tables;
+    }
+
+} /// namespace land_snapshot
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "infiniverse_rows.hpp"
+#include "land_snapshot.hpp"
+
+// Converts between snapshot records and the contract's packed rows, and moves whole tables between a
+// snapshot and the host harness. Everything here throws std::runtime_error on rows a snapshot can't hold.
+namespace land_snapshot {
+
+    land_record to_record(const infiniverse_rows::land& row, eosio::name payer);
+    persistent_record to_record(const infiniverse_rows::persistent& row, eosio::name payer);
+    poly_record to_record(const infiniverse_rows::poly& row, eosio::name payer);
+    deposit_record to_record(const infiniverse_rows::deposit& row);
+
+    infiniverse_rows::land to_row(const land_record& record);
+    infiniverse_rows::persistent to_row(const persistent_record& record);
+    infiniverse_rows::poly to_row(const poly_record& record);
+    infiniverse_rows::deposit to_row(const deposit_record& record);
+
+    // Reads the contract's tables out of the host harness. Lands and polys must be migrated
+    snapshot_tables export_host_tables(eosio::name contract);
+
+    // Fills the contract's empty tables in the host harness from a snapshot in one pass, billing every row
+    // to its recorded payer, and marks the land migration done
+    void load_host_tables(eosio::name contract, const snapshot_view& snapshot);
+
+    // Text form of a snapshot for the snapshot tool, one "<table> <scope> <payer> <hex of the packed row>" line
+    // per row after a "next_persistent_id <id>" line
+    std::vector<std::string> dump_rows(const snapshot_view& snapshot);
+    snapshot_tables parse_rows(const std::vector<std::string>& lines);
+
+} /// namespace land_snapshot
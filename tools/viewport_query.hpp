@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "lat_long_functions.cpp"
+#include "z_order_functions.cpp"
+
+// Client side of a viewport query against the land table's byzorder index, the same walk the contract
+// runs in for_each_land_in_box. Edges are signed micro degrees.
+namespace viewport_query {
+
+    // Longest side of a land, as the contract enforces it
+    const int64_t max_land_length_mm = 100 * 1000;
+
+    struct viewport {
+        int32_t lat_north_edge;
+        int32_t long_east_edge;
+        int32_t lat_south_edge;
+        int32_t long_west_edge;
+    };
+
+    // The byzorder key of a land, the z-order code of its south west corner
+    template<typename Land>
+    uint64_t land_corner_key(const Land& land)
+    {
+        return z_order_encode(long_to_z_coord(land.long_west_edge), lat_to_z_coord(land.lat_south_edge));
+    }
+
+    // Box of the corner keys a land intersecting the viewport can have. A land can start up to its maximum
+    // length south and west of the viewport and still reach into it
+    struct corner_keys {
+        uint64_t z_min;
+        uint64_t z_max;
+    };
+
+    inline corner_keys viewport_corner_keys(const viewport& view)
+    {
+        int32_t lat_south_bound = view.lat_south_edge - millimeters_to_lat_span(max_land_length_mm);
+        int32_t long_west_bound = view.long_west_edge - millimeters_to_long_span(max_land_length_mm,
+            view.lat_north_edge, view.lat_south_edge);
+        return {z_order_encode(long_to_z_coord(long_west_bound), lat_to_z_coord(lat_south_bound)),
+            z_order_encode(long_to_z_coord(view.long_east_edge), lat_to_z_coord(view.lat_north_edge))};
+    }
+
+    // Returns the lands intersecting the viewport. read_page(lower_bound) returns rows of the byzorder index
+    // in key order starting at the first key at or above lower_bound, like get_table_rows with
+    // index_position 3, key_type i64 and that lower_bound; an empty page is the end of the table. Rows need
+    // the edges of the land table. When a row's corner lies outside the box the walk queries again at the
+    // next key inside it, instead of paging through the keys between the corners.
+    template<typename ReadPage>
+    auto lands_in_viewport(const viewport& view, ReadPage&& read_page, size_t* pages_read = nullptr)
+        -> std::vector<typename std::decay_t<decltype(read_page(uint64_t()))>::value_type>
+    {
+        typedef typename std::decay_t<decltype(read_page(uint64_t()))>::value_type land_row;
+
+        corner_keys keys = viewport_corner_keys(view);
+        std::vector<land_row> lands;
+        uint64_t lower_bound = keys.z_min;
+        size_t pages = 0;
+        bool done = false;
+        while(!done)
+        {
+            std::vector<land_row> page = read_page(lower_bound);
+            pages++;
+            done = page.empty();
+            for(size_t i = 0; i < page.size(); i++)
+            {
+                uint64_t z_value = land_corner_key(page[i]);
+                if(z_value > keys.z_max)
+                {
+                    done = true;
+                    break;
+                }
+                if(!z_order_in_box(z_value, keys.z_min, keys.z_max))
+                {
+                    lower_bound = z_order_next_in_box(z_value, keys.z_min, keys.z_max);
+                    break;
+                }
+                if(lands_intersect(page[i], view))
+                {
+                    lands.push_back(page[i]);
+                }
+                // Keys are unique, lands with the same corner would overlap
+                if(i + 1 == page.size())
+                {
+                    done = z_value == keys.z_max;
+                    lower_bound = z_value + 1;
+                }
+            }
+        }
+        if(pages_read)
+        {
+            *pages_read = pages;
+        }
+        return lands;
+    }
+
+} /// namespace viewport_query